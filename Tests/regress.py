@@ -0,0 +1,354 @@
+#!/usr/bin/env python3
+"""Golden-output regression run of the spidercam simulator.
+
+Every entry of scenarios.txt is simulated in a scratch directory. Its output
+files (_1.out/_2.out or .traj) are compared with Tests/golden within a
+numeric tolerance, the median wall time and peak RSS of --repeat runs with
+the recorded budgets.
+Entries with --decimate e are also run in float64 binary with and without
+the decimation; the cable lengths interpolated between the kept samples
+must stay within e of every full sample. Entries whose scenario has a
+`winch vmax amax` directive are run in float64 binary, the rope speeds and
+accelerations of the finite differences of the cable lengths must stay
+within the limits. The exit status is 1 when an entry fails.
+
+    regress.py --binary build/spidercam [--rtol r] [--atol a] [--only label]
+               [--repeat n] [--config name]
+    regress.py --binary build/spidercam --update
+
+--update records the current outputs as golden files and writes new budgets
+of twice the median wall time plus 10 ms and 1.25 times the median peak RSS
+plus 1 MB; review the diff before committing it. The budgets hold for a
+Release build, --config with another build configuration (CTest passes its
+own) checks the outputs only.
+"""
+
+import argparse
+import bisect
+import math
+import os
+import re
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+MANIFEST = os.path.join(HERE, "scenarios.txt")
+GOLDEN = os.path.join(HERE, "golden")
+SUFFIXES = ("_1.out", "_2.out", ".traj")
+PEAK_RSS = re.compile(r"^peak RSS kB\s+(\d+)", re.M)
+NUMBER = re.compile(r"[-+]?(?:\d+\.?\d*|\.\d+)(?:[eE][-+]?\d+)?$|[-+]?(?:inf|nan)$")
+
+
+class Entry:
+    def __init__(self, label, scenario, wall_ms, rss_kb, options):
+        self.label = label
+        self.scenario = scenario
+        self.wall_ms = wall_ms
+        self.rss_kb = rss_kb
+        self.options = options
+
+
+def read_manifest():
+    """label scenario wall_ms rss_kb [options...], # starts a comment"""
+    entries = []
+    with open(MANIFEST) as f:
+        for line in f:
+            fields = line.split("#", 1)[0].split()
+            if not fields:
+                continue
+            entries.append(Entry(fields[0], fields[1], float(fields[2]), float(fields[3]), fields[4:]))
+    return entries
+
+
+def write_manifest(entries):
+    header = []
+    with open(MANIFEST) as f:
+        for line in f:
+            if not line.startswith("#"):
+                break
+            header.append(line)
+    with open(MANIFEST, "w") as f:
+        f.writelines(header)
+        for e in entries:
+            line = "%-12s %-16s %8d %8d  %s" % (e.label, e.scenario, e.wall_ms, e.rss_kb, " ".join(e.options))
+            f.write(line.rstrip() + "\n")
+
+
+def run(binary, scenario, name, options, workdir):
+    """Runs a scenario as workdir/name, returns (exit code, wall seconds, peak RSS in kB, outputs)."""
+    shutil.copy(os.path.join(HERE, scenario), os.path.join(workdir, name))
+    # the profile reports the simulator's own peak RSS, ru_maxrss of the
+    # child would include the image of this interpreter inherited at fork
+    command = [binary, "--events", "none", "--profile"] + options + [name]
+    begin = time.perf_counter()
+    process = subprocess.Popen(command, cwd=workdir, stdout=subprocess.DEVNULL,
+                               stderr=subprocess.PIPE, universal_newlines=True)
+    _, errors = process.communicate()
+    wall = time.perf_counter() - begin
+    outputs = {}
+    for suffix in SUFFIXES:
+        path = os.path.join(workdir, name + suffix)
+        if os.path.exists(path):
+            outputs[suffix] = path
+    peak = PEAK_RSS.search(errors)
+    rss = int(peak.group(1)) if peak else 0
+    return process.returncode, wall, rss, outputs
+
+
+def median(values):
+    ordered = sorted(values)
+    middle = len(ordered) // 2
+    return ordered[middle] if len(ordered) % 2 else (ordered[middle - 1] + ordered[middle]) / 2
+
+
+def close(a, b, rtol, atol):
+    if math.isnan(a) or math.isnan(b):
+        return math.isnan(a) and math.isnan(b)
+    return abs(a - b) <= atol + rtol * abs(b)
+
+
+def compare_text(path, golden, rtol, atol):
+    """Token by token, numbers within the tolerance; returns an error or None."""
+    with open(path) as f:
+        lines = f.read().splitlines()
+    with open(golden) as f:
+        expected = f.read().splitlines()
+    if len(lines) != len(expected):
+        return "%d lines instead of %d" % (len(lines), len(expected))
+    for n, (line, reference) in enumerate(zip(lines, expected), 1):
+        tokens = re.split(r"[,\s]+", line.strip())
+        references = re.split(r"[,\s]+", reference.strip())
+        if len(tokens) != len(references):
+            return "line %d: %d values instead of %d" % (n, len(tokens), len(references))
+        for k, (a, b) in enumerate(zip(tokens, references)):
+            if NUMBER.match(a) and NUMBER.match(b):
+                if not close(float(a), float(b), rtol, atol):
+                    return "line %d value %d: %s instead of %s" % (n, k + 1, a, b)
+            elif a != b:
+                return "line %d value %d: %r instead of %r" % (n, k + 1, a, b)
+    return None
+
+
+def read_traj(path):
+    """Header fields and per segment (entry, columns), see trajectoryformat.h."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:8] != b"SPCTRAJ\0":
+        raise ValueError("not a trajectory file")
+    version, sample_type = struct.unpack_from("<II", data, 8)
+    dim = struct.unpack_from("<3d", data, 16)
+    freq, vmax, amax = struct.unpack_from("<3d", data, 40)
+    cables, columns, count, table = struct.unpack_from("<IIQQ", data, 64)
+    scale = struct.unpack_from("<d", data, 88)[0] if version >= 2 else 0.0
+    code, size = {0: ("d", 8), 1: ("f", 4), 2: ("i", 4)}[sample_type]
+    header = (version, sample_type, dim, freq, vmax, amax, cables, columns, count, scale)
+    segments = []
+    for s in range(count):
+        offset, samples, start, command, _ = struct.unpack_from("<QQdif", data, table + 32 * s)
+        stride = (samples * size + 7) & ~7
+        values = [struct.unpack_from("<%d%s" % (samples, code), data, offset + c * stride)
+                  for c in range(columns)]
+        segments.append(((samples, start, command), values))
+    return header, segments
+
+
+def compare_traj(path, golden, rtol, atol):
+    header, segments = read_traj(path)
+    reference, expected = read_traj(golden)
+    if header != reference:
+        return "header %s instead of %s" % (header, reference)
+    # fixed-point samples are integers, one step of the scale is the tolerance
+    step = 1.0 if header[1] == 2 else 0.0
+    for s, ((entry, values), (reference, columns)) in enumerate(zip(segments, expected)):
+        if entry[0] != reference[0] or entry[2] != reference[2] or not close(entry[1], reference[1], rtol, atol):
+            return "segment %d: %s instead of %s" % (s, entry, reference)
+        for c, (column, expect) in enumerate(zip(values, columns)):
+            for j, (a, b) in enumerate(zip(column, expect)):
+                if not close(a, b, rtol, atol + step):
+                    return "segment %d column %d sample %d: %r instead of %r" % (s, c, j, a, b)
+    return None
+
+
+def interpolate(times, values, t):
+    k = min(max(bisect.bisect_right(times, t) - 1, 0), len(times) - 1)
+    if k + 1 == len(times) or times[k + 1] == times[k]:
+        return values[k]
+    w = (t - times[k]) / (times[k + 1] - times[k])
+    return values[k] + w * (values[k + 1] - values[k])
+
+
+def float64_run(binary, entry, workdir, name, extra):
+    """Runs the entry in float64 binary without decimation plus extra options;
+    returns the segments of the .traj file or None."""
+    options = list(entry.options)
+    for option in ("--decimate", "--precision"):
+        if option in options:
+            k = options.index(option)
+            del options[k:k + 2]
+    options = [o for o in options if o != "--binary"] + ["--binary"] + extra
+    code, _, _, outputs = run(binary, entry.scenario, name, options, workdir)
+    if code != 0 or ".traj" not in outputs:
+        return None
+    return read_traj(outputs[".traj"])[1]
+
+
+def check_decimation(binary, entry, workdir):
+    """Decodes the decimated run in float64 binary; returns an error or None."""
+    tolerance = float(entry.options[entry.options.index("--decimate") + 1])
+    full = float64_run(binary, entry, workdir, "full.txt", [])
+    decimated = float64_run(binary, entry, workdir, "decimated.txt", ["--decimate", str(tolerance)])
+    if full is None or decimated is None:
+        return "decimation check: the float64 runs failed"
+    if len(full) != len(decimated):
+        return "decimation check: %d segments instead of %d" % (len(decimated), len(full))
+    worst = 0.0
+    for (_, columns), (_, kept) in zip(full, decimated):
+        times = list(kept[0])
+        for c in range(4, len(columns)):
+            for t, value in zip(columns[0], columns[c]):
+                worst = max(worst, abs(interpolate(times, kept[c], t) - value))
+    if worst > tolerance * (1 + 1e-9):
+        return "decimation error %g exceeds the tolerance %g" % (worst, tolerance)
+    return None
+
+
+def winch_limits(scenario):
+    with open(os.path.join(HERE, scenario)) as f:
+        for line in f:
+            fields = line.split("#", 1)[0].split()
+            if len(fields) == 3 and fields[0] == "winch":
+                return float(fields[1]), float(fields[2])
+    return None
+
+
+def check_winch(binary, entry, workdir, limits):
+    """Rope speed and acceleration from central differences of the cable
+    lengths; returns an error or None."""
+    segments = float64_run(binary, entry, workdir, "winch.txt", [])
+    if segments is None:
+        return "winch check: the float64 run failed"
+    speed = acceleration = 0.0
+    for _, columns in segments:
+        t = columns[0]
+        for lengths in columns[4:]:
+            for j in range(1, len(lengths) - 1):
+                h1, h2 = t[j] - t[j - 1], t[j + 1] - t[j]
+                if h1 <= 0 or h2 <= 0:
+                    continue
+                speed = max(speed, abs(lengths[j + 1] - lengths[j - 1]) / (h1 + h2))
+                acceleration = max(acceleration, abs(2 * ((lengths[j + 1] - lengths[j]) / h2 -
+                                                          (lengths[j] - lengths[j - 1]) / h1) / (h1 + h2)))
+    # the differences smooth the jumps of the acceleration at phase borders,
+    # a few percent cover their error on the peaks
+    if limits[0] > 0 and speed > limits[0] * 1.001:
+        return "rope speed %g exceeds the winch limit %g" % (speed, limits[0])
+    if limits[1] > 0 and acceleration > limits[1] * 1.02:
+        return "rope acceleration %g exceeds the winch limit %g" % (acceleration, limits[1])
+    return None
+
+
+def main():
+    parser = argparse.ArgumentParser(description="golden-output regression run")
+    parser.add_argument("--binary", default="./build/spidercam", help="the spidercam executable")
+    parser.add_argument("--rtol", type=float, default=1e-9, help="relative tolerance of the values")
+    parser.add_argument("--atol", type=float, default=1e-9, help="absolute tolerance of the values")
+    parser.add_argument("--only", help="run a single entry")
+    parser.add_argument("--update", action="store_true", help="record the goldens and budgets")
+    parser.add_argument("--repeat", type=int, default=5, help="runs per entry, their medians are budgeted")
+    parser.add_argument("--config", default="Release", help="build configuration of the binary")
+    args = parser.parse_args()
+
+    binary = os.path.abspath(args.binary)
+    if not os.access(binary, os.X_OK):
+        print("no executable %s, build it first" % binary)
+        return 1
+
+    budgeted = args.config == "Release"
+    if not budgeted:
+        print("%s build, the wall time and peak RSS budgets are not checked" % args.config)
+    if args.update and not budgeted:
+        print("the budgets are recorded with a Release build")
+        return 1
+
+    entries = read_manifest()
+    failures = 0
+    runs = 0
+    with tempfile.TemporaryDirectory(prefix="spidercam_regress_") as workdir:
+        for entry in entries:
+            if args.only and entry.label != args.only:
+                continue
+            runs += 1
+            walls = []
+            peaks = []
+            for _ in range(max(args.repeat, 1)):
+                code, wall, rss, outputs = run(binary, entry.scenario, entry.label + ".txt", entry.options, workdir)
+                walls.append(wall)
+                peaks.append(rss)
+                if code != 0:
+                    break
+            wall = median(walls)
+            rss = median(peaks)
+            problems = []
+            if code != 0:
+                problems.append("exit status %d" % code)
+            if not outputs:
+                problems.append("no output")
+            if not rss:
+                problems.append("no peak RSS in the profile")
+
+            if args.update:
+                for suffix in SUFFIXES:
+                    golden = os.path.join(GOLDEN, entry.label + suffix)
+                    if suffix in outputs:
+                        shutil.copy(outputs[suffix], golden)
+                    elif os.path.exists(golden):
+                        os.remove(golden)
+                entry.wall_ms = math.ceil(wall * 1e3 * 2 + 10)
+                entry.rss_kb = math.ceil(rss * 1.25 + 1024)
+            else:
+                for suffix in SUFFIXES:
+                    golden = os.path.join(GOLDEN, entry.label + suffix)
+                    if os.path.exists(golden) != (suffix in outputs):
+                        problems.append("%s %s" % (entry.label + suffix,
+                                                   "missing" if os.path.exists(golden) else "has no golden file"))
+                    elif suffix in outputs:
+                        compare = compare_traj if suffix == ".traj" else compare_text
+                        error = compare(outputs[suffix], golden, args.rtol, args.atol)
+                        if error:
+                            problems.append("%s: %s" % (entry.label + suffix, error))
+                if "--decimate" in entry.options:
+                    error = check_decimation(binary, entry, workdir)
+                    if error:
+                        problems.append(error)
+                limits = winch_limits(entry.scenario)
+                if limits:
+                    error = check_winch(binary, entry, workdir, limits)
+                    if error:
+                        problems.append(error)
+                if budgeted and wall * 1e3 > entry.wall_ms:
+                    problems.append("wall time %.1f ms over the budget of %d ms" % (wall * 1e3, entry.wall_ms))
+                if budgeted and rss > entry.rss_kb:
+                    problems.append("peak RSS %d kB over the budget of %d kB" % (rss, entry.rss_kb))
+
+            print("%-4s %-12s %8.1f ms / %6d ms %8d kB / %6d kB" %
+                  ("FAIL" if problems else "ok", entry.label, wall * 1e3, entry.wall_ms, rss, entry.rss_kb))
+            for problem in problems:
+                print("     " + problem)
+            failures += bool(problems)
+            for path in os.listdir(workdir):
+                os.remove(os.path.join(workdir, path))
+
+    if args.update:
+        write_manifest(entries)
+        print("goldens and budgets recorded, review the diff of Tests/")
+    elif failures:
+        print("%d of %d scenarios failed" % (failures, runs))
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
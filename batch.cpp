@@ -0,0 +1,154 @@
+#include "batch.h"
+#include "simulation.h"
+#include "workstealingpool.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/**
+ * @brief The BatchResult struct, summary of one scenario file
+ */
+struct BatchResult
+{
+    SimulationStats stats;
+    double seconds{};
+    string error;
+};
+
+/**
+ * @brief isScenario filters the files of a directory like runall.sh does:
+ *        no backups, scripts or output files
+ */
+bool isScenario(const fs::path &path)
+{
+    const string name = path.filename().string();
+    const string extension = path.extension().string();
+    return !name.empty() && name.back() != '~' && extension != ".py" &&
+           extension != ".out" && extension != ".traj" && extension != ".sh";
+}
+
+}
+
+/**
+ * @brief batchFiles the scenario files of a batch run
+ * @param source : a directory or a text file with one scenario per line
+ * @return the files, sorted by name
+ */
+vector<string> batchFiles(const string &source)
+{
+    vector<string> files;
+    if (fs::is_directory(source))
+    {
+        for (const fs::directory_entry &entry : fs::directory_iterator(source))
+            if (entry.is_regular_file() && isScenario(entry.path()))
+                files.push_back(entry.path().string());
+        std::sort(files.begin(), files.end());
+    }
+    else
+    {
+        std::ifstream list(source);
+        string line;
+        while (std::getline(list, line))
+        {
+            line.erase(0, line.find_first_not_of(" \t"));
+            line.erase(line.find_last_not_of(" \t\r") + 1);
+            if (!line.empty() && line[0] != '#')
+                files.push_back(line);
+        }
+    }
+    return files;
+}
+
+/**
+ * @brief runBatch simulates many scenario files concurrently. The biggest
+ *        files are submitted first so they do not end up last on a worker.
+ * @param source : a directory or a list file, see batchFiles()
+ * @param options : threads and output format
+ * @param out : receives the per-file summary and the aggregate timing
+ * @return the number of files that could not be simulated
+ */
+int runBatch(const string &source, const BatchOptions &options, std::ostream &out)
+{
+    const vector<string> files = batchFiles(source);
+    vector<BatchResult> results(files.size());
+
+    vector<size_t> order(files.size());
+    std::iota(order.begin(), order.end(), 0);
+    vector<uintmax_t> sizes(files.size());
+    for (size_t k = 0; k < files.size(); k++)
+    {
+        std::error_code error;
+        sizes[k] = fs::file_size(files[k], error);
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&sizes](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+    unsigned threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+    auto begin = std::chrono::steady_clock::now();
+    {
+        WorkStealingPool pool(threads);
+        for (size_t k : order)
+        {
+            pool.submit([&files, &results, &options, k] {
+                auto start = std::chrono::steady_clock::now();
+                try
+                {
+                    NullSink quiet;
+                    Simulation sim(files[k]);
+                    sim.setObserver(&quiet);
+                    sim.setMotionProfile(options.motion);
+                    sim.setBlendRadius(options.blendRadius);
+                    sim.ioData().setDecimation(options.decimation);
+                    sim.ioData().setOutputFormat(options.format, options.sampleType, options.fixedScale);
+                    sim.simulate();
+                    results[k].stats = sim.getStats();
+                }
+                catch (const std::exception &e)
+                {
+                    results[k].error = e.what();
+                }
+                results[k].seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            });
+        }
+        pool.wait();
+    }
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    int errors = 0;
+    double cpu = 0;
+    SimulationStats total;
+    for (size_t k = 0; k < files.size(); k++)
+    {
+        const BatchResult &r = results[k];
+        out << files[k] << ": ";
+        if (!r.error.empty())
+        {
+            out << "error: " << r.error << '\n';
+            errors++;
+            continue;
+        }
+        out << r.stats.succeeded << " succeeded, " << r.stats.failed << " failed, "
+            << r.stats.skipped << " skipped, " << r.stats.samples << " samples, "
+            << r.seconds * 1000 << " ms\n";
+        total.succeeded += r.stats.succeeded;
+        total.failed += r.stats.failed;
+        total.skipped += r.stats.skipped;
+        total.samples += r.stats.samples;
+        cpu += r.seconds;
+    }
+    out << files.size() << " files on " << threads << " threads: "
+        << total.succeeded << " succeeded, " << total.failed << " failed, "
+        << total.skipped << " skipped, " << total.samples << " samples" << '\n'
+        << "wall time " << wall * 1000 << " ms, sum of file times " << cpu * 1000 << " ms"
+        << std::endl;
+    return errors;
+}
@@ -0,0 +1,30 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "trajectorywriter.h"
+#include "segmentprofile.h"
+#include <ostream>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+/**
+ * @brief The BatchOptions struct, settings of a batch run
+ */
+struct BatchOptions
+{
+    unsigned threads{0};        //0: one per hardware thread
+    OutputFormat format{OutputFormat::Text};
+    trajectoryformat::SampleType sampleType{trajectoryformat::SampleType::Float64};
+    double fixedScale{trajectoryformat::defaultFixedScale};
+    MotionProfile motion{MotionProfile::Trapezoid};
+    double blendRadius{0};
+    double decimation{0};       //tolerance of the output decimation, 0: off
+};
+
+vector<string> batchFiles(const string &source);
+int runBatch(const string &source, const BatchOptions &options, std::ostream &out);
+
+#endif // BATCH_H
@@ -0,0 +1,440 @@
+#include <algorithm>
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <new>
+#include <unistd.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "simulation.h"
+#include "trajectoryindex.h"
+#include "decimation.h"
+#include "incrementalsimulation.h"
+#include "quantization.h"
+#include "playback.h"
+
+/**
+ * Benchmark suite of the simulation, one measurement per stage of the
+ * pipeline on a synthetic scenario. The report is JSON.
+ *
+ * spidercam_bench [--waypoints n] [--dim x y z] [--freq f] [--vmax v]
+ *                 [--amax a] [--jmax j] [--tolerance e] [--lines n] [--repeat n]
+ *                 [--json file]
+ *
+ * --jmax runs the scenario with the S-curve profile. --tolerance is the
+ * error bound of the decimation stage, whose bound is checked by the
+ * regression run (Tests/regress.py). The bench checks that the command loop
+ * of a warm run does not touch the heap, that an edit gives the same
+ * schedule as a full run and that the quantization errors stay within one
+ * half step (fixed32, millimetres) or one float32 rounding. The playback
+ * stage checks that the number of heap allocations does not depend on the
+ * number of samples emitted.
+ */
+
+//heap allocations of the process, counted to check the command and emit loops
+std::atomic<size_t> heapAllocations{0};
+
+void *operator new(size_t size)
+{
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace {
+
+struct Scenario
+{
+    long waypoints{2000};
+    int dim[3]{100, 80, 30};
+    int freq{100};
+    int vmax{5};
+    int amax{2};
+    int jmax{0};                //> 0: S-curve profile
+    double tolerance{0.001};    //of the output decimation
+    long parseLines{1000000};   //instructions of the parser benchmark
+    int repeat{3};
+};
+
+struct Stage
+{
+    std::string name;
+    double seconds{};
+    double items{};
+    std::string unit;
+    double bytes{};
+};
+
+/**
+ * @brief writeScenario generates a synthetic input file. The waypoints are
+ *        spread far enough in time for every command to succeed.
+ * @param fileName : the file to be written
+ * @param waypoints : number of instructions
+ */
+void writeScenario(const Scenario &s, const std::string &fileName, long waypoints)
+{
+    std::ofstream out(fileName);
+    out << "# synthetic scenario of spidercam_bench\n"
+        << "dim " << s.dim[0] << ' ' << s.dim[1] << ' ' << s.dim[2] << '\n'
+        << "start " << s.dim[0] / 2 << ' ' << s.dim[1] / 2 << ' ' << s.dim[2] / 2 << '\n'
+        << "vmax " << s.vmax << "\namax " << s.amax << "\nfreq " << s.freq << '\n';
+    if (s.jmax > 0)
+        out << "jmax " << s.jmax << '\n';
+    double diagonal = std::sqrt(double(s.dim[0]) * s.dim[0] + double(s.dim[1]) * s.dim[1] +
+                                double(s.dim[2]) * s.dim[2]);
+    double step = std::ceil(diagonal / s.vmax + 2.0 * s.vmax / s.amax +
+                            (s.jmax > 0 ? 2.0 * s.amax / s.jmax : 0) + 1);
+    unsigned seed = 1;
+    for (long i = 0; i < waypoints; i++)
+    {
+        double p[3];
+        for (int k = 0; k < 3; k++)
+        {
+            seed = seed * 1103515245u + 12345u;
+            p[k] = (seed >> 8) % 100000 / 100000.0 * s.dim[k];
+        }
+        out << (i + 1) * step << ' ' << p[0] << ' ' << p[1] << ' ' << p[2]
+            << "   # waypoint " << i << '\n';
+    }
+}
+
+template <class F>
+double seconds(int repeat, F f)
+{
+    double best = 0;
+    for (int r = 0; r < repeat; r++)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        f();
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        if (r == 0 || elapsed < best)
+            best = elapsed;
+    }
+    return best;
+}
+
+long fileSize(const std::string &fileName)
+{
+    std::ifstream in(fileName, std::ios::binary | std::ios::ate);
+    return in ? static_cast<long>(in.tellg()) : 0;
+}
+
+/**
+ * @brief The BenchSimulation class gives access to the per-command buffers
+ */
+class BenchSimulation : public Simulation
+{
+public:
+    explicit BenchSimulation(const std::string &fileName) : Simulation(fileName) {}
+    TrajectoryBuffer &buffer() { return trajectory; }
+    int commands() { return iodata.getInstructionsSize() - 1; }
+};
+
+void writeJson(std::ostream &out, const Scenario &s, const std::vector<Stage> &stages)
+{
+    out << "{\n  \"scenario\": {\"waypoints\": " << s.waypoints
+        << ", \"dim\": [" << s.dim[0] << ", " << s.dim[1] << ", " << s.dim[2] << "]"
+        << ", \"freq\": " << s.freq << ", \"vmax\": " << s.vmax << ", \"amax\": " << s.amax
+        << ", \"jmax\": " << s.jmax
+        << ", \"parse_lines\": " << s.parseLines << ", \"repeat\": " << s.repeat
+        << ", \"cable_kernel\": \"" << cableKernelName() << "\""
+        << ", \"quantization_kernel\": \"" << quantizationKernelName() << "\"},\n  \"stages\": [\n";
+    for (size_t k = 0; k < stages.size(); k++)
+    {
+        const Stage &st = stages[k];
+        out << "    {\"name\": \"" << st.name << "\", \"seconds\": " << st.seconds
+            << ", \"" << st.unit << "\": " << st.items
+            << ", \"" << st.unit << "_per_s\": " << (st.seconds > 0 ? st.items / st.seconds : 0);
+        if (st.bytes > 0)
+            out << ", \"mb_per_s\": " << (st.seconds > 0 ? st.bytes / st.seconds / 1e6 : 0);
+        out << "}" << (k + 1 < stages.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    Scenario s;
+    std::string json;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg(argv[i]);
+        if (arg == "--waypoints" && i + 1 < argc)
+            s.waypoints = std::atol(argv[++i]);
+        else if (arg == "--dim" && i + 3 < argc)
+            for (int k = 0; k < 3; k++)
+                s.dim[k] = std::atoi(argv[++i]);
+        else if (arg == "--freq" && i + 1 < argc)
+            s.freq = std::atoi(argv[++i]);
+        else if (arg == "--vmax" && i + 1 < argc)
+            s.vmax = std::atoi(argv[++i]);
+        else if (arg == "--amax" && i + 1 < argc)
+            s.amax = std::atoi(argv[++i]);
+        else if (arg == "--jmax" && i + 1 < argc)
+            s.jmax = std::atoi(argv[++i]);
+        else if (arg == "--tolerance" && i + 1 < argc)
+            s.tolerance = std::atof(argv[++i]);
+        else if (arg == "--lines" && i + 1 < argc)
+            s.parseLines = std::atol(argv[++i]);
+        else if (arg == "--repeat" && i + 1 < argc)
+            s.repeat = std::atoi(argv[++i]);
+        else if (arg == "--json" && i + 1 < argc)
+            json = argv[++i];
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--waypoints n] [--dim x y z] [--freq f]"
+                      << " [--vmax v] [--amax a] [--jmax j] [--tolerance e] [--lines n] [--repeat n] [--json file]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<Stage> stages;
+    int status = 0;
+
+    //parsing
+    const std::string parseFile = "spidercam_bench_parse.txt";
+    writeScenario(s, parseFile, s.parseLines);
+    double parseBytes = fileSize(parseFile);
+    int sizeStream = 0, sizeFast = 0;
+    stages.push_back({"parse_stream", seconds(1, [&] { IOData d; d.einlesenStream(parseFile); sizeStream = d.getInstructionsSize(); }),
+                      double(s.parseLines), "lines", parseBytes});
+    stages.push_back({"parse_fast", seconds(s.repeat, [&] { IOData d; d.einlesen(parseFile); sizeFast = d.getInstructionsSize(); }),
+                      double(s.parseLines), "lines", parseBytes});
+    std::remove(parseFile.c_str());
+    if (sizeStream != sizeFast)
+    {
+        std::cerr << "parsers disagree: " << sizeStream << " vs " << sizeFast << " instructions" << std::endl;
+        status = 1;
+    }
+
+    //simulation stages
+    const std::string scenarioFile = "spidercam_bench_scenario.txt";
+    writeScenario(s, scenarioFile, s.waypoints);
+    BenchSimulation sim(scenarioFile);
+    NullSink quiet;
+    sim.setObserver(&quiet);
+    if (s.jmax > 0)
+        sim.setMotionProfile(MotionProfile::SCurve);
+
+    double samples = 0;
+    for (int i = 0; i < sim.commands(); i++)
+    {
+        sim.calculateTimeIntervals(i);
+        samples += sim.buffer().size();
+    }
+    stages.push_back({"kinematics", seconds(s.repeat, [&] {
+                          for (int i = 0; i < sim.commands(); i++)
+                          {
+                              sim.calculateTimeIntervals(i);
+                              sim.currentLine_G(i);
+                          }
+                      }), samples, "samples", 0});
+
+    //cable lengths on one long buffer, to measure the kernel alone
+    TrajectoryBuffer &buffer = sim.buffer();
+    sim.calculateTimeIntervals(0);
+    sim.currentLine_G(0);
+    const size_t segmentSamples = buffer.size();
+    const int kernelRounds = std::max<int>(1, int(samples / std::max<size_t>(segmentSamples, 1)));
+    stages.push_back({"cable_lengths", seconds(s.repeat, [&] {
+                          for (int r = 0; r < kernelRounds; r++)
+                              sim.calculateLengthSteelCables(0);
+                      }), double(kernelRounds) * segmentSamples, "samples", 0});
+
+    //decimation
+    {
+        Decimator decimator;
+        TrajectoryBuffer decimated;
+        size_t kept = 0;
+        stages.push_back({"decimate", seconds(s.repeat, [&] {
+                              for (int r = 0; r < kernelRounds; r++)
+                                  kept = decimator.decimate(buffer, s.tolerance, decimated);
+                          }), double(kernelRounds) * segmentSamples, "samples", 0});
+        std::cerr << "decimation kept " << kept << " of " << segmentSamples << " samples" << std::endl;
+    }
+
+    //quantization of the cable lengths to float32 and to fixed-point millimetres
+    {
+        std::vector<float> narrow(segmentSamples);
+        std::vector<int32_t> fixed(segmentSamples);
+        double narrowError = 0, fixedError = 0, largest = 0;
+        for (size_t j = 0; j < segmentSamples; j++)
+            largest = std::max(largest, std::fabs(buffer.cable(0)[j]));
+        stages.push_back({"quantize_float32", seconds(s.repeat, [&] {
+                              for (int r = 0; r < kernelRounds; r++)
+                                  narrowError = quantizeFloat32(buffer.cable(0), segmentSamples, 0, narrow.data());
+                          }), double(kernelRounds) * segmentSamples, "samples", 0});
+        stages.push_back({"quantize_fixed32", seconds(s.repeat, [&] {
+                              for (int r = 0; r < kernelRounds; r++)
+                                  fixedError = quantizeFixed32(buffer.cable(0), segmentSamples, 0,
+                                                               trajectoryformat::defaultFixedScale, fixed.data());
+                          }), double(kernelRounds) * segmentSamples, "samples", 0});
+        std::cerr << "quantization error float32 " << narrowError << ", fixed32 " << fixedError << std::endl;
+        if (narrowError > std::ldexp(largest, -24) || fixedError > 0.5 / trajectoryformat::defaultFixedScale * (1 + 1e-9))
+        {
+            std::cerr << "quantization error exceeds half a step" << std::endl;
+            status = 1;
+        }
+    }
+
+    //output formatting
+    const double bytesPerSample = (4.0 + buffer.cableCount()) * sizeof(double);
+    {
+        double textBytes = 0;
+        stages.push_back({"output_text", seconds(s.repeat, [&] {
+                              TextTrajectoryWriter writer(scenarioFile, {double(s.dim[0]), double(s.dim[1]), double(s.dim[2])});
+                              for (int r = 0; r < kernelRounds; r++)
+                                  writer.writeSegment(buffer, r, r);
+                              writer.close();
+                              textBytes = fileSize(scenarioFile + "_1.out") + fileSize(scenarioFile + "_2.out");
+                          }), double(kernelRounds) * segmentSamples, "samples", 0});
+        stages.back().bytes = textBytes;
+        stages.push_back({"output_binary", seconds(s.repeat, [&] {
+                              BinaryTrajectoryWriter writer(scenarioFile, {double(s.dim[0]), double(s.dim[1]), double(s.dim[2])},
+                                                            s.freq, s.vmax, s.amax, trajectoryformat::SampleType::Float64,
+                                                            buffer.cableCount());
+                              for (int r = 0; r < kernelRounds; r++)
+                                  writer.writeSegment(buffer, r, r);
+                              writer.close();
+                          }), double(kernelRounds) * segmentSamples, "samples",
+                          double(kernelRounds) * segmentSamples * bytesPerSample});
+    }
+
+    //whole run
+    stages.push_back({"simulate_text", seconds(s.repeat, [&] { sim.simulate(); }),
+                      double(sim.getStats().samples), "samples", 0});
+    sim.ioData().setOutputFormat(OutputFormat::Binary);
+    stages.push_back({"simulate_binary", seconds(s.repeat, [&] { sim.simulate(); }),
+                      double(sim.getStats().samples), "samples", 0});
+
+    //heap allocations of the command loop of a warm run, sampled on threads
+    //and decimated; the first command opens the output files
+    {
+        SamplingOptions parallel;
+        parallel.threads = 4;
+        parallel.parallelThreshold = 0;
+        sim.setSamplingOptions(parallel);
+        sim.ioData().setDecimation(s.tolerance);
+        sim.simulate();
+        sim.reset();
+        sim.step();
+        const size_t before = heapAllocations.load();
+        while (sim.step())
+            ;
+        const size_t allocated = heapAllocations.load() - before;
+        sim.ioData().closeOutput();
+        sim.ioData().setDecimation(0);
+        sim.setSamplingOptions(SamplingOptions());
+        if (allocated != 0)
+        {
+            std::cerr << "the command loop allocated " << allocated << " times" << std::endl;
+            status = 1;
+        }
+    }
+
+    //edit of the middle waypoint, compared with a full run of the edited list
+    {
+        IncrementalSimulation incremental(scenarioFile);
+        incremental.setObserver(&quiet);
+        if (s.jmax > 0)
+            incremental.setMotionProfile(MotionProfile::SCurve);
+        incremental.simulate();
+        const int middle = incremental.ioData().getInstructionsSize() / 2;
+        std::array<double,4> instruction = incremental.ioData().getInstruction(middle);
+        PatchedRange range;
+        stages.push_back({"incremental_edit", seconds(s.repeat, [&] {
+                              instruction[1] = s.dim[0] - instruction[1];
+                              range = incremental.setInstruction(middle, instruction);
+                          }), 1, "edits", 0});
+        //the samples follow from the command and its start time
+        std::vector<std::array<double,4>> patched;
+        for (const CommandDecision &d : incremental.results())
+            patched.push_back({double(d.command), d.startTime, double(d.succeeded), d.executionTime});
+        incremental.simulate();
+        size_t mismatches = patched.size() != incremental.results().size();
+        for (size_t k = 0; !mismatches && k < patched.size(); k++)
+        {
+            const CommandDecision &d = incremental.results()[k];
+            mismatches += patched[k] != std::array<double,4>{double(d.command), d.startTime, double(d.succeeded), d.executionTime};
+        }
+        std::cerr << "incremental edit recomputed " << range.recomputed << " of "
+                  << incremental.results().size() << " commands" << std::endl;
+        if (mismatches)
+        {
+            std::cerr << "incremental edit differs from a full run" << std::endl;
+            status = 1;
+        }
+    }
+
+    //random access
+    TrajectoryIndex index(sim.ioData(), sim.anchorPoints());
+    const long queries = 1000000;
+    double sink = 0;
+    stages.push_back({"index_query", seconds(s.repeat, [&] {
+                          double end = index.endTime();
+                          for (long q = 0; q < queries; q++)
+                              sink += index.at(end * q / queries).cables[0];
+                      }), double(queries), "queries", 0});
+    if (sink == -1)
+        std::cout << sink;
+
+    //paced playback to /dev/null at 2 kHz, a short and a longer one
+    {
+        int fd = ::open("/dev/null", O_WRONLY);
+        PlaybackOptions options;
+        PlaybackStats stats;
+        size_t allocations[2];
+        const double spans[2] = {0.05, 0.25};
+        for (int r = 0; r < 2; r++)
+        {
+            options.to = spans[r];
+            Playback playback(index, 2000, options);
+            size_t before = heapAllocations.load();
+            stats = playback.run(fd);
+            allocations[r] = heapAllocations.load() - before;
+        }
+        ::close(fd);
+        stages.push_back({"playback", spans[1], double(stats.emitted), "samples", 0});
+        std::cerr << "playback " << stats.emitted << " samples, " << stats.misses << " misses, jitter "
+                  << stats.jitter * 1e6 << " us, max lateness " << stats.maxLateness * 1e6 << " us" << std::endl;
+        if (allocations[1] != allocations[0])
+        {
+            std::cerr << "the playback emit loop allocated " << allocations[1] - allocations[0] << " times" << std::endl;
+            status = 1;
+        }
+    }
+
+    for (const char *suffix : {"", "_1.out", "_2.out", ".traj"})
+        std::remove((scenarioFile + suffix).c_str());
+
+    if (json.empty())
+        writeJson(std::cout, s, stages);
+    else
+    {
+        std::ofstream out(json);
+        writeJson(out, s, stages);
+    }
+    return status;
+}
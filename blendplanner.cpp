@@ -0,0 +1,236 @@
+#include "blendplanner.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const double epsilon = 1e-12;
+
+array<double,3> along(const array<double,3> &p, const array<double,3> &u, double s)
+{
+    return {p[0] + s * u[0], p[1] + s * u[1], p[2] + s * u[2]};
+}
+
+array<double,3> scaled(const array<double,3> &u, double s)
+{
+    return {s * u[0], s * u[1], s * u[2]};
+}
+
+double norm(const array<double,3> &u)
+{
+    return std::sqrt(u[0] * u[0] + u[1] * u[1] + u[2] * u[2]);
+}
+
+}
+
+/**
+ * @brief BlendedSegment::position the camera's position
+ * @param t : time since the start of the command, clamped to [0, duration]
+ */
+array<double, 3> BlendedSegment::position(double t) const
+{
+    t = std::min(std::max(t, 0.0), duration);
+    size_t k = 0;
+    while (k + 1 < pieces.size() && t >= pieces[k + 1].begin)
+        k++;
+    const BlendPiece &p = pieces[k];
+    double d = t - p.begin;
+    array<double,3> result;
+    for (size_t c = 0; c < result.size(); c++)
+        result[c] = p.position[c] + d * (p.velocity[c] + d * p.acceleration[c] / 2);
+    return result;
+}
+
+/**
+ * @brief BlendedSegment::velocity the camera's velocity
+ * @param t : time since the start of the command, clamped to [0, duration]
+ */
+array<double, 3> BlendedSegment::velocity(double t) const
+{
+    t = std::min(std::max(t, 0.0), duration);
+    size_t k = 0;
+    while (k + 1 < pieces.size() && t >= pieces[k + 1].begin)
+        k++;
+    const BlendPiece &p = pieces[k];
+    double d = t - p.begin;
+    array<double,3> result;
+    for (size_t c = 0; c < result.size(); c++)
+        result[c] = p.velocity[c] + d * p.acceleration[c];
+    return result;
+}
+
+/**
+ * @brief BlendPlanner::BlendPlanner
+ * @param radius : largest distance between a waypoint and the blend around it
+ * @param lookahead : most commands of one chain
+ */
+BlendPlanner::BlendPlanner(double radius, size_t lookahead_) :
+    blendRadius(radius),
+    lookahead(lookahead_ < 2 ? 2 : lookahead_)
+{
+}
+
+/**
+ * @brief BlendPlanner::plan the chain starting at a command that fails from
+ *        rest to rest. The chain grows until every one of its waypoints is
+ *        reached by its scheduled time.
+ * @param iodata : the instructions with the current start times
+ * @param first : the command level the chain starts with
+ * @return the chain, empty if no chain within the lookahead is in time
+ */
+BlendChain BlendPlanner::plan(const IOData &iodata, int first) const
+{
+    const int count = iodata.getInstructionsSize();
+    if (blendRadius <= 0 || first < 0 || first + 2 >= count)
+        return BlendChain();
+
+    for (int last = first + 1; last + 1 < count && static_cast<size_t>(last - first + 1) <= lookahead; last++)
+    {
+        BlendChain chain = build(iodata, first, last);
+        if (std::all_of(chain.segments.begin(), chain.segments.end(),
+                        [](const BlendedSegment &segment) { return segment.decision.succeeded; }))
+            return chain;
+    }
+    return BlendChain();
+}
+
+/**
+ * @brief BlendPlanner::build plans the commands first..last without stop,
+ *        from rest at waypoint first to rest at waypoint last+1. A command
+ *        succeeds when it reaches its waypoint by the scheduled time, like
+ *        a command from rest to rest.
+ */
+BlendChain BlendPlanner::build(const IOData &iodata, int first, int last) const
+{
+    const double vmax = iodata.getVmax();
+    const double amax = iodata.getAmax();
+    const int segments = last - first + 1;
+
+    vector<Waypoint> waypoints(segments + 1);
+    for (int j = 0; j <= segments; j++)
+        waypoints[j] = {{iodata.getInstruction(first + j, 1), iodata.getInstruction(first + j, 2),
+                         iodata.getInstruction(first + j, 3)}, 0, 0, 0, {0, 0, 0}};
+
+    vector<double> length(segments);
+    vector<array<double,3>> direction(segments);
+    for (int s = 0; s < segments; s++)
+    {
+        array<double,3> d;
+        for (size_t c = 0; c < d.size(); c++)
+            d[c] = waypoints[s + 1].point[c] - waypoints[s].point[c];
+        length[s] = norm(d);
+        direction[s] = length[s] > epsilon ? scaled(d, 1 / length[s]) : array<double,3>{0, 0, 0};
+    }
+
+    //pass speeds limited by the blend radius, then by amax along the chain
+    vector<double> radius(segments + 1, 0), turn(segments + 1, 0);
+    for (int j = 1; j < segments; j++)
+    {
+        radius[j] = std::min(blendRadius, std::min(length[j - 1], length[j]) / 2);
+        turn[j] = norm({direction[j][0] - direction[j - 1][0], direction[j][1] - direction[j - 1][1],
+                        direction[j][2] - direction[j - 1][2]});
+        double speed = vmax;
+        if (length[j - 1] <= epsilon || length[j] <= epsilon)
+            speed = 0;
+        else if (turn[j] > epsilon)
+            speed = std::min(vmax, std::sqrt(2 * radius[j] * amax / turn[j]));
+        waypoints[j].speed = speed;
+    }
+    vector<double> straight(segments);
+    for (int s = 0; s < segments; s++)
+        straight[s] = std::max(0.0, length[s] - radius[s] - radius[s + 1]);
+    for (int s = segments - 1; s >= 0; s--)
+        waypoints[s].speed = std::min(waypoints[s].speed,
+                                      std::sqrt(waypoints[s + 1].speed * waypoints[s + 1].speed + 2 * amax * straight[s]));
+    for (int s = 0; s < segments; s++)
+        waypoints[s + 1].speed = std::min(waypoints[s + 1].speed,
+                                          std::sqrt(waypoints[s].speed * waypoints[s].speed + 2 * amax * straight[s]));
+
+    //blends: the velocity turns from direction j-1 to direction j with amax
+    for (int j = 1; j < segments; j++)
+    {
+        Waypoint &w = waypoints[j];
+        if (turn[j] <= epsilon || w.speed <= epsilon)
+            continue;
+        w.duration = w.speed * turn[j] / amax;
+        w.distance = w.speed * w.duration / 2;
+        for (size_t c = 0; c < w.acceleration.size(); c++)
+            w.acceleration[c] = amax * (direction[j][c] - direction[j - 1][c]) / turn[j];
+    }
+
+    BlendChain chain;
+    chain.first = first;
+    chain.last = last;
+    double startTime = iodata.getInstruction(first, 0);
+    for (int s = 0; s < segments; s++)
+    {
+        BlendedSegment segment;
+        double t = 0;
+        const Waypoint &from = waypoints[s];
+        const Waypoint &to = waypoints[s + 1];
+        const array<double,3> &u = direction[s];
+
+        if (from.duration > 0)
+        {
+            const array<double,3> &previous = direction[s - 1];
+            double half = from.duration / 2;
+            BlendPiece piece{0, along(from.point, previous, -from.distance), scaled(previous, from.speed),
+                             from.acceleration};
+            for (size_t c = 0; c < 3; c++)
+            {
+                piece.position[c] += half * (piece.velocity[c] + half * piece.acceleration[c] / 2);
+                piece.velocity[c] += half * piece.acceleration[c];
+            }
+            segment.pieces.push_back(piece);
+            t = half;
+        }
+        segment.stages[0] = t;
+
+        //straight part, trapezoid from the pass speed of `from` to the one of `to`
+        const double v0 = from.speed, v1 = to.speed;
+        const double lineLength = std::max(0.0, length[s] - from.distance - to.distance);
+        double peak = std::min(vmax, std::sqrt((2 * amax * lineLength + v0 * v0 + v1 * v1) / 2));
+        peak = std::max(peak, std::max(v0, v1));
+        const double accelerating = (peak - v0) / amax;
+        const double decelerating = (peak - v1) / amax;
+        const double cruiseLength = lineLength - (peak * peak - v0 * v0) / (2 * amax) -
+                                    (peak * peak - v1 * v1) / (2 * amax);
+        const double cruising = peak > epsilon ? std::max(0.0, cruiseLength / peak) : 0;
+
+        double s0 = from.distance;
+        double v = v0;
+        const double phases[3][2] = {{accelerating, amax}, {cruising, 0}, {decelerating, -amax}};
+        for (const auto &phase : phases)
+        {
+            if (phase[0] <= 0)
+                continue;
+            segment.pieces.push_back({t, along(from.point, u, s0), scaled(u, v), scaled(u, phase[1])});
+            s0 += phase[0] * (v + phase[0] * phase[1] / 2);
+            v += phase[0] * phase[1];
+            t += phase[0];
+        }
+        segment.stages[1] = t;
+
+        if (to.duration > 0)
+        {
+            segment.pieces.push_back({t, along(to.point, u, -to.distance), scaled(u, to.speed), to.acceleration});
+            t += to.duration / 2;
+        }
+        if (segment.pieces.empty())
+            segment.pieces.push_back({0, from.point, {0, 0, 0}, {0, 0, 0}});
+        segment.duration = t;
+        segment.stages[2] = t;
+
+        CommandDecision &decision = segment.decision;
+        decision.command = first + s;
+        decision.startTime = startTime;
+        decision.executionTime = t;
+        decision.nextStartTime = iodata.getInstruction(first + s + 1, 0);
+        decision.succeeded = decision.nextStartTime == 0 ||
+                             decision.startTime + decision.executionTime < decision.nextStartTime;
+        decision.next = first + s + 1;
+        startTime += t;
+        chain.segments.push_back(segment);
+    }
+    return chain;
+}
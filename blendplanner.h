@@ -0,0 +1,92 @@
+#ifndef BLENDPLANNER_H
+#define BLENDPLANNER_H
+
+#include "inputData.h"
+#include "commandscheduler.h"
+#include <array>
+#include <vector>
+
+using std::array;
+using std::vector;
+
+/**
+ * @brief The BlendPiece struct, motion with a constant acceleration vector
+ *        from `begin` (time since the start of the command) on
+ */
+struct BlendPiece
+{
+    double begin;
+    array<double,3> position;
+    array<double,3> velocity;
+    array<double,3> acceleration;
+};
+
+/**
+ * @brief The BlendedSegment struct
+ *
+ * One command of a blend chain: from the middle of the blend at its start
+ * waypoint (or from rest) to the middle of the blend at its end waypoint
+ * (or to rest). Straight parts and parabolic blends are all pieces of
+ * constant acceleration.
+ */
+struct BlendedSegment
+{
+    CommandDecision decision;
+    double duration{};
+    array<double,3> stages{};       //begin and end of the straight part, end
+    vector<BlendPiece> pieces;
+
+    array<double,3> position(double t) const;
+    array<double,3> velocity(double t) const;
+};
+
+/**
+ * @brief The BlendChain struct, consecutive commands executed without stop
+ */
+struct BlendChain
+{
+    int first{-1};
+    int last{-1};
+    vector<BlendedSegment> segments;    //first..last
+
+    bool contains(int i) const { return first <= i && i <= last; }
+    const BlendedSegment &segment(int i) const { return segments[i - first]; }
+};
+
+/**
+ * @brief The BlendPlanner class
+ *
+ * Lookahead planner for commands whose timing is too tight to stop at every
+ * waypoint. Starting at a command that fails from rest to rest, the chain
+ * greedily takes the following commands in, passing each waypoint on a
+ * parabolic blend of at most `radius` instead of stopping, until every
+ * waypoint of the chain is reached by its scheduled time. When the
+ * lookahead is used up first there is no chain and the command fails from
+ * rest to rest as usual. The pass speeds respect vmax and amax (forward and
+ * backward pass over the chain).
+ */
+class BlendPlanner
+{
+public:
+    BlendPlanner(double radius, size_t lookahead = 32);
+
+    double radius() const { return blendRadius; }
+    BlendChain plan(const IOData &iodata, int first) const;
+
+private:
+    struct Waypoint
+    {
+        array<double,3> point;
+        double speed;           //pass speed
+        double distance;        //the blend starts and ends that far from the point
+        double duration;        //of the blend
+        array<double,3> acceleration;
+    };
+
+    BlendChain build(const IOData &iodata, int first, int last) const;
+
+    double blendRadius;
+    size_t lookahead;
+};
+
+#endif // BLENDPLANNER_H
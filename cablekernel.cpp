@@ -0,0 +1,212 @@
+#include "cablekernel.h"
+#include "cpufeatures.h"
+#include <cmath>
+
+namespace {
+
+/**
+ * @brief scalarKernel reference implementation for a rig of N anchors,
+ *        also used for the tail of the vectorized kernel
+ * @param first : index of the first sample to be calculated
+ * @param last : index after the last sample to be calculated
+ */
+template <size_t N>
+void scalarKernel(TrajectoryBuffer &trajectory, const RigModel<N> &rig, size_t first, size_t last)
+{
+    const double *x = trajectory.x();
+    const double *y = trajectory.y();
+    const double *z = trajectory.z();
+    double *cable[N];
+    for (size_t k = 0; k < N; k++)
+        cable[k] = trajectory.cable(k);
+
+    for (size_t j = first; j < last; j++)
+    {
+        for (size_t k = 0; k < N; k++)
+        {
+            double dx = x[j] - rig.anchors[k][0];
+            double dy = y[j] - rig.anchors[k][1];
+            double dz = z[j] - rig.anchors[k][2];
+            cable[k][j] = std::sqrt(dx * dx + dy * dy + dz * dz);
+        }
+    }
+}
+
+/**
+ * @brief scalarKernel generic rig, the anchor count is only known at runtime
+ */
+void scalarKernel(TrajectoryBuffer &trajectory, const AnchorPoints &anchors, size_t first, size_t last)
+{
+    const double *x = trajectory.x();
+    const double *y = trajectory.y();
+    const double *z = trajectory.z();
+    for (size_t j = first; j < last; j++)
+    {
+        for (size_t k = 0; k < anchors.size(); k++)
+        {
+            double dx = x[j] - anchors[k][0];
+            double dy = y[j] - anchors[k][1];
+            double dz = z[j] - anchors[k][2];
+            trajectory.cable(k)[j] = std::sqrt(dx * dx + dy * dy + dz * dz);
+        }
+    }
+}
+
+#ifdef SPIDERCAM_HAVE_AVX2_KERNEL
+/**
+ * @brief avx2Kernel 4 samples per iteration, all anchors per load of x/y/z.
+ *        Uses the same operation order as scalarKernel (no FMA), so both
+ *        produce identical results. first must be a multiple of 4.
+ */
+template <size_t N>
+__attribute__((target("avx2")))
+void avx2Kernel(TrajectoryBuffer &trajectory, const RigModel<N> &rig, size_t first, size_t last)
+{
+    const double *x = trajectory.x();
+    const double *y = trajectory.y();
+    const double *z = trajectory.z();
+    const size_t n = first + ((last - first) & ~static_cast<size_t>(3));
+
+    __m256d ax[N], ay[N], az[N];
+    double *cable[N];
+    for (size_t k = 0; k < N; k++)
+    {
+        ax[k] = _mm256_set1_pd(rig.anchors[k][0]);
+        ay[k] = _mm256_set1_pd(rig.anchors[k][1]);
+        az[k] = _mm256_set1_pd(rig.anchors[k][2]);
+        cable[k] = trajectory.cable(k);
+    }
+
+    for (size_t j = first; j < n; j += 4)
+    {
+        __m256d px = _mm256_load_pd(x + j);
+        __m256d py = _mm256_load_pd(y + j);
+        __m256d pz = _mm256_load_pd(z + j);
+        for (size_t k = 0; k < N; k++)
+        {
+            __m256d dx = _mm256_sub_pd(px, ax[k]);
+            __m256d dy = _mm256_sub_pd(py, ay[k]);
+            __m256d dz = _mm256_sub_pd(pz, az[k]);
+            __m256d sum = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)),
+                                        _mm256_mul_pd(dz, dz));
+            _mm256_store_pd(cable[k] + j, _mm256_sqrt_pd(sum));
+        }
+    }
+    scalarKernel(trajectory, rig, n, last);
+}
+
+/**
+ * @brief avx2Kernel generic rig, the anchor count is only known at runtime
+ */
+__attribute__((target("avx2")))
+void avx2Kernel(TrajectoryBuffer &trajectory, const AnchorPoints &anchors, size_t first, size_t last)
+{
+    const double *x = trajectory.x();
+    const double *y = trajectory.y();
+    const double *z = trajectory.z();
+    const size_t n = first + ((last - first) & ~static_cast<size_t>(3));
+
+    for (size_t j = first; j < n; j += 4)
+    {
+        __m256d px = _mm256_load_pd(x + j);
+        __m256d py = _mm256_load_pd(y + j);
+        __m256d pz = _mm256_load_pd(z + j);
+        for (size_t k = 0; k < anchors.size(); k++)
+        {
+            __m256d dx = _mm256_sub_pd(px, _mm256_set1_pd(anchors[k][0]));
+            __m256d dy = _mm256_sub_pd(py, _mm256_set1_pd(anchors[k][1]));
+            __m256d dz = _mm256_sub_pd(pz, _mm256_set1_pd(anchors[k][2]));
+            __m256d sum = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)),
+                                        _mm256_mul_pd(dz, dz));
+            _mm256_store_pd(trajectory.cable(k) + j, _mm256_sqrt_pd(sum));
+        }
+    }
+    scalarKernel(trajectory, anchors, n, last);
+}
+#endif
+
+const bool useAvx2 = cpuHasAvx2();
+
+/**
+ * @brief runRig the kernel of a rig with N anchors
+ */
+template <size_t N>
+void runRig(TrajectoryBuffer &trajectory, const AnchorPoints &anchors, size_t first, size_t last)
+{
+    RigModel<N> rig;
+    for (size_t k = 0; k < N; k++)
+        rig.anchors[k] = anchors[k];
+#ifdef SPIDERCAM_HAVE_AVX2_KERNEL
+    if (useAvx2)
+    {
+        avx2Kernel(trajectory, rig, first, last);
+        return;
+    }
+#endif
+    scalarKernel(trajectory, rig, first, last);
+}
+
+}
+
+/**
+ * @brief cornerAnchors the anchorage points at the top corners of the arena
+ * @param dim : dimension of the arena
+ */
+AnchorPoints cornerAnchors(const array<double, 3> &dim)
+{
+    return {{0, 0, dim[2]},
+            {dim[0], 0, dim[2]},
+            {0, dim[1], dim[2]},
+            {dim[0], dim[1], dim[2]}};
+}
+
+/**
+ * @brief calculateCableLengths fills the cable columns of the buffer
+ * @param trajectory : buffer with the sampled camera positions
+ * @param anchors : the anchorage points of the cables
+ */
+void calculateCableLengths(TrajectoryBuffer &trajectory, const AnchorPoints &anchors)
+{
+    calculateCableLengths(trajectory, anchors, 0, trajectory.size());
+}
+
+/**
+ * @brief calculateCableLengths fills the cable columns for a range of samples
+ *        with the kernel specialized for the size of the rig
+ * @param first : first sample, a multiple of 4
+ * @param last : sample after the last one
+ */
+void calculateCableLengths(TrajectoryBuffer &trajectory, const AnchorPoints &anchors,
+                           size_t first, size_t last)
+{
+    switch (anchors.size())
+    {
+    case 4:
+        runRig<4>(trajectory, anchors, first, last);
+        return;
+    case 6:
+        runRig<6>(trajectory, anchors, first, last);
+        return;
+    case 8:
+        runRig<8>(trajectory, anchors, first, last);
+        return;
+    default:
+        break;
+    }
+#ifdef SPIDERCAM_HAVE_AVX2_KERNEL
+    if (useAvx2)
+    {
+        avx2Kernel(trajectory, anchors, first, last);
+        return;
+    }
+#endif
+    scalarKernel(trajectory, anchors, first, last);
+}
+
+/**
+ * @brief cableKernelName name of the kernel selected for this CPU
+ */
+const char *cableKernelName()
+{
+    return useAvx2 ? "avx2" : "scalar";
+}
@@ -0,0 +1,37 @@
+#ifndef CABLEKERNEL_H
+#define CABLEKERNEL_H
+
+#include "trajectorybuffer.h"
+#include <array>
+#include <vector>
+
+using std::array;
+using std::vector;
+
+/**
+ * Anchorage points of the steel cables. A rig has between 1 and maxAnchors
+ * winches; without `anchor x y z` directives the four top corners of the
+ * arena are used.
+ */
+typedef vector<array<double,3>> AnchorPoints;
+const size_t maxAnchors = 16;
+
+/**
+ * @brief The RigModel class, a rig with N anchors known at compile time.
+ *        The lengths of all N cables are computed in one fused pass over
+ *        x/y/z. Specialized kernels exist for N = 4, 6 and 8, other rigs
+ *        use a generic kernel with a runtime anchor count.
+ */
+template <size_t N>
+struct RigModel
+{
+    array<array<double,3>, N> anchors;
+};
+
+AnchorPoints cornerAnchors(const array<double,3> &dim);
+void calculateCableLengths(TrajectoryBuffer &trajectory, const AnchorPoints &anchors);
+void calculateCableLengths(TrajectoryBuffer &trajectory, const AnchorPoints &anchors,
+                           size_t first, size_t last);
+const char *cableKernelName();
+
+#endif // CABLEKERNEL_H
@@ -0,0 +1,188 @@
+#include "cablekinematics.h"
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief CableKinematics::CableKinematics
+ * @param iodata : motion limits, anchors and winch limits of the run
+ */
+CableKinematics::CableKinematics(const IOData &iodata) :
+    limits(iodata.getMotionLimits()),
+    anchors(iodata.getAnchors()),
+    winch(iodata.getWinchLimits())
+{
+}
+
+/**
+ * @brief CableKinematics::rates rope speed and acceleration of every winch
+ * @param profile : the command
+ * @param t : time since the start of the command
+ */
+CableRates CableKinematics::rates(const SegmentProfile &profile, double t) const
+{
+    CableRates result;
+    const array<double,3> p = profile.position(t);
+    const double v = profile.speed(t);
+    const double a = profile.acceleration(t);
+    for (size_t k = 0; k < anchors.size(); k++)
+    {
+        double r[3] = {p[0] - anchors[k][0], p[1] - anchors[k][1], p[2] - anchors[k][2]};
+        double length = std::sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2]);
+        if (length <= 0)
+            continue;
+        double along = r[0] * profile.direction[0] + r[1] * profile.direction[1] + r[2] * profile.direction[2];
+        result.speed[k] = along * v / length;
+        result.acceleration[k] = ((1 - along * along / (length * length)) * v * v + along * a) / length;
+    }
+    return result;
+}
+
+/**
+ * @brief CableKinematics::closestApproach the time the camera passes closest
+ *        to anchor k. r.u grows with the distance travelled, so it is the
+ *        root of r.u, or an end of the command.
+ */
+double CableKinematics::closestApproach(const SegmentProfile &profile, size_t k) const
+{
+    auto along = [&](double t) {
+        const array<double,3> p = profile.position(t);
+        return (p[0] - anchors[k][0]) * profile.direction[0] + (p[1] - anchors[k][1]) * profile.direction[1]
+             + (p[2] - anchors[k][2]) * profile.direction[2];
+    };
+    double low = 0, high = profile.t_c;
+    if (along(low) >= 0)
+        return low;
+    if (along(high) <= 0)
+        return high;
+    for (int n = 0; n < 50; n++)
+    {
+        const double middle = 0.5 * (low + high);
+        (along(middle) < 0 ? low : high) = middle;
+    }
+    return 0.5 * (low + high);
+}
+
+/**
+ * @brief CableKinematics::refine golden-section search of the largest rope
+ *        speed or acceleration of all winches in [a, b]
+ */
+double CableKinematics::refine(const SegmentProfile &profile, double a, double b, bool acceleration) const
+{
+    auto largest = [&](double t) {
+        CableRates r = rates(profile, t);
+        double value = 0;
+        for (size_t k = 0; k < anchors.size(); k++)
+            value = std::max(value, std::fabs(acceleration ? r.acceleration[k] : r.speed[k]));
+        return value;
+    };
+    const double ratio = 0.5 * (std::sqrt(5.0) - 1);
+    double x1 = b - ratio * (b - a), x2 = a + ratio * (b - a);
+    double f1 = largest(x1), f2 = largest(x2);
+    for (int n = 0; n < 30; n++)
+    {
+        if (f1 < f2)
+        {
+            a = x1;
+            x1 = x2;
+            f1 = f2;
+            x2 = a + ratio * (b - a);
+            f2 = largest(x2);
+        }
+        else
+        {
+            b = x2;
+            x2 = x1;
+            f2 = f1;
+            x1 = b - ratio * (b - a);
+            f1 = largest(x1);
+        }
+    }
+    return std::max(f1, f2);
+}
+
+/**
+ * @brief CableKinematics::timeScale the factor k >= 1 the command has to be
+ *        stretched by to keep the winches within their limits. Inside every
+ *        phase the rates are evaluated on a grid and at the closest
+ *        approaches to the anchors; the search is then refined between the
+ *        neighbours of the largest speed and of the largest acceleration.
+ */
+double CableKinematics::timeScale(const SegmentProfile &profile) const
+{
+    if (!limited() || profile.t_c <= 0)
+        return 1;
+
+    const int steps = 16;
+    array<double,maxAnchors> closest{};
+    for (size_t k = 0; k < anchors.size(); k++)
+        closest[k] = closestApproach(profile, k);
+
+    double speed = 0, acceleration = 0;
+    array<double,2> fastest{}, steepest{};      //neighbours of the largest values
+    array<double,steps + 1 + maxAnchors> times;
+    for (int ph = 0; ph < profile.phaseCount; ph++)
+    {
+        const double begin = profile.phases[ph].begin;
+        const double end = ph + 1 < profile.phaseCount ? profile.phases[ph + 1].begin : profile.t_c;
+        if (end <= begin)
+            continue;
+        //stay inside the phase, the acceleration jumps at its borders
+        const double low = begin + 1e-9 * (end - begin), high = end - 1e-9 * (end - begin);
+        size_t count = 0;
+        for (int j = 0; j <= steps; j++)
+            times[count++] = std::min(std::max(begin + (end - begin) * j / steps, low), high);
+        for (size_t k = 0; k < anchors.size(); k++)
+            if (closest[k] > low && closest[k] < high)
+                times[count++] = closest[k];
+        std::sort(times.begin(), times.begin() + count);
+
+        for (size_t j = 0; j < count; j++)
+        {
+            CableRates r = rates(profile, times[j]);
+            const double before = times[j > 0 ? j - 1 : 0], after = times[std::min(j + 1, count - 1)];
+            for (size_t k = 0; k < anchors.size(); k++)
+            {
+                if (std::fabs(r.speed[k]) > speed)
+                {
+                    speed = std::fabs(r.speed[k]);
+                    fastest = {before, after};
+                }
+                if (std::fabs(r.acceleration[k]) > acceleration)
+                {
+                    acceleration = std::fabs(r.acceleration[k]);
+                    steepest = {before, after};
+                }
+            }
+        }
+    }
+    if (winch[0] > 0)
+        speed = std::max(speed, refine(profile, fastest[0], fastest[1], false));
+    if (winch[1] > 0)
+        acceleration = std::max(acceleration, refine(profile, steepest[0], steepest[1], true));
+
+    double scale = 1;
+    if (winch[0] > 0)
+        scale = std::max(scale, speed / winch[0]);
+    if (winch[1] > 0)
+        scale = std::max(scale, std::sqrt(acceleration / winch[1]));
+    return scale;
+}
+
+/**
+ * @brief CableKinematics::profile the motion profile of a command, slowed
+ *        down uniformly if a winch would exceed its limits
+ * @param start : start point of the command
+ * @param end : end point of the command
+ */
+SegmentProfile CableKinematics::profile(const array<double, 3> &start, const array<double, 3> &end) const
+{
+    SegmentProfile nominal(start, end, limits);
+    const double k = timeScale(nominal);
+    if (k <= 1)
+        return nominal;
+    MotionLimits slowed = limits;
+    slowed.vmax /= k;
+    slowed.amax /= k * k;
+    slowed.jmax /= k * k * k;
+    return SegmentProfile(start, end, slowed);
+}
@@ -0,0 +1,56 @@
+#ifndef CABLEKINEMATICS_H
+#define CABLEKINEMATICS_H
+
+#include "inputData.h"
+#include "segmentprofile.h"
+#include "cablekernel.h"
+#include <array>
+
+using std::array;
+
+/**
+ * @brief The CableRates struct, rope speed and acceleration of every winch
+ */
+struct CableRates
+{
+    array<double,maxAnchors> speed{};           //dL/dt
+    array<double,maxAnchors> acceleration{};    //d2L/dt2
+};
+
+/**
+ * @brief The CableKinematics class
+ *
+ * Inverse kinematics of the cables along a command. With r = P - A the
+ * vector from an anchor to the camera and u the direction of the line,
+ * L = |r|, dL/dt = (r.u) s' / L and d2L/dt2 = ((1 - (r.u)^2/L^2) s'^2 +
+ * (r.u) s'') / L, with s', s'' from the motion profile.
+ *
+ * Stretching a profile in time by k divides the rope speeds by k and the
+ * rope accelerations by k^2; building it with vmax/k, amax/k^2 and jmax/k^3
+ * gives exactly that profile. profile() uses the smallest k that keeps
+ * every winch within the limits of the `winch vmax amax` directive.
+ *
+ * The rope acceleration peaks where the camera passes closest to an anchor,
+ * with a width of about distance / speed, so timeScale() evaluates the
+ * rates at those times as well as on a grid, then refines the largest ones.
+ */
+class CableKinematics
+{
+public:
+    explicit CableKinematics(const IOData &iodata);
+
+    SegmentProfile profile(const array<double,3> &start, const array<double,3> &end) const;
+    CableRates rates(const SegmentProfile &profile, double t) const;
+    double timeScale(const SegmentProfile &profile) const;
+    bool limited() const { return winch[0] > 0 || winch[1] > 0; }
+
+private:
+    double closestApproach(const SegmentProfile &profile, size_t k) const;
+    double refine(const SegmentProfile &profile, double a, double b, bool acceleration) const;
+
+    MotionLimits limits;
+    AnchorPoints anchors;
+    array<double,2> winch;      //rope vmax, amax, 0: unlimited
+};
+
+#endif // CABLEKINEMATICS_H
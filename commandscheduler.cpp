@@ -0,0 +1,89 @@
+#include "commandscheduler.h"
+
+/**
+ * @brief decideCommand decides whether command i succeeds. A failed command
+ *        stops the camera; if it stops after the start time of command i+2,
+ *        that command has to be rescheduled to the stop time and runs next.
+ * @param profile : the motion profile of command i
+ * @param i : command level
+ * @param startTime : start time of command i
+ * @param nextStartTime : start time of command i+1
+ * @param afterNextStartTime : start time of command i+2, nullptr when
+ *                             command i+2 is the last instruction or missing
+ * @return the decision for command i, the caller applies the rescheduling
+ */
+CommandDecision decideCommand(const SegmentProfile &profile, int i, double startTime,
+                              double nextStartTime, const double *afterNextStartTime)
+{
+    CommandDecision decision;
+    decision.command = i;
+    decision.startTime = startTime;
+    decision.executionTime = profile.t_c;
+    decision.nextStartTime = nextStartTime;
+
+    if (decision.nextStartTime == 0 ||
+        (decision.startTime + decision.executionTime < decision.nextStartTime))
+    {
+        decision.succeeded = true;
+        decision.next = i + 1;
+        return decision;
+    }
+
+    double available = decision.nextStartTime - decision.startTime;
+    decision.cameraStopTime = decision.startTime + available +
+                              profile.stoppingTime(available);
+
+    if (afterNextStartTime && decision.cameraStopTime > *afterNextStartTime)
+    {
+        decision.rescheduled = true;
+        decision.next = i + 2;
+    }
+    return decision;
+}
+
+/**
+ * @brief decideCommand decides command i of the instruction table without
+ *        changing it
+ * @param iodata : the instructions
+ * @param profile : the motion profile of command i
+ * @param i : command level
+ * @return the decision for command i
+ */
+CommandDecision decideCommand(const IOData &iodata, const SegmentProfile &profile, int i)
+{
+    double afterNext = 0;
+    bool hasAfterNext = i + 2 < iodata.getInstructionsSize() - 1;
+    if (hasAfterNext)
+        afterNext = iodata.getInstruction(i+2,0);
+
+    CommandDecision decision = decideCommand(profile, i, iodata.getInstruction(i,0),
+                                             iodata.getInstruction(i+1,0),
+                                             hasAfterNext ? &afterNext : nullptr);
+    return decision;
+}
+
+/**
+ * @brief applyDecision moves the start time of the rescheduled command
+ * @param iodata : the instructions
+ * @param decision : a decision of decideCommand or of a blend chain
+ */
+void applyDecision(IOData &iodata, const CommandDecision &decision)
+{
+    if (decision.rescheduled)
+        iodata.setInstruction(decision.next,0) = decision.cameraStopTime;
+}
+
+/**
+ * @brief scheduleCommand decides command i of the instruction table and
+ *        applies the rescheduling of command i+2
+ * @param iodata : the instructions, the start time of command i+2 may be changed
+ * @param profile : the motion profile of command i
+ * @param i : command level
+ * @return the decision for command i
+ */
+CommandDecision scheduleCommand(IOData &iodata, const SegmentProfile &profile, int i)
+{
+    CommandDecision decision = decideCommand(iodata, profile, i);
+    applyDecision(iodata, decision);
+    return decision;
+}
@@ -0,0 +1,31 @@
+#ifndef COMMANDSCHEDULER_H
+#define COMMANDSCHEDULER_H
+
+#include "inputData.h"
+#include "segmentprofile.h"
+
+/**
+ * @brief The CommandDecision struct
+ *
+ * Outcome of the scheduling of one command: whether the camera reaches the
+ * end point before the next command starts, and which command runs next.
+ */
+struct CommandDecision
+{
+    int command{};
+    bool succeeded{};
+    double startTime{};
+    double executionTime{};
+    double nextStartTime{};
+    double cameraStopTime{};    //only set when the command failed
+    bool rescheduled{};         //the start time of command+2 was moved
+    int next{-1};               //next command level, -1 ends the simulation
+};
+
+CommandDecision decideCommand(const SegmentProfile &profile, int i, double startTime,
+                              double nextStartTime, const double *afterNextStartTime);
+CommandDecision decideCommand(const IOData &iodata, const SegmentProfile &profile, int i);
+void applyDecision(IOData &iodata, const CommandDecision &decision);
+CommandDecision scheduleCommand(IOData &iodata, const SegmentProfile &profile, int i);
+
+#endif // COMMANDSCHEDULER_H
@@ -0,0 +1,18 @@
+#include "cpufeatures.h"
+
+/**
+ * @brief cpuHasAvx2 checks the CPU once
+ * @return true if the AVX2 kernels can run
+ */
+bool cpuHasAvx2()
+{
+#ifdef SPIDERCAM_HAVE_AVX2_KERNEL
+    static const bool avx2 = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+    }();
+    return avx2;
+#else
+    return false;
+#endif
+}
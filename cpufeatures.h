@@ -0,0 +1,17 @@
+#ifndef CPUFEATURES_H
+#define CPUFEATURES_H
+
+/**
+ * Runtime dispatch of the vectorized kernels. SPIDERCAM_HAVE_AVX2_KERNEL is
+ * defined where the compiler can build AVX2 functions with
+ * __attribute__((target("avx2"))); cpuHasAvx2() tells whether the CPU the
+ * program runs on can execute them.
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SPIDERCAM_HAVE_AVX2_KERNEL
+#include <immintrin.h>
+#endif
+
+bool cpuHasAvx2();
+
+#endif // CPUFEATURES_H
@@ -0,0 +1,125 @@
+#include "decimation.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+void copySample(const TrajectoryBuffer &from, size_t j, TrajectoryBuffer &to, size_t k)
+{
+    to.t()[k] = from.t()[j];
+    to.x()[k] = from.x()[j];
+    to.y()[k] = from.y()[j];
+    to.z()[k] = from.z()[j];
+    for (size_t c = 0; c < from.cableCount(); c++)
+        to.cable(c)[k] = from.cable(c)[j];
+}
+
+}
+
+/**
+ * @brief Decimator::reserve sizes the cone bounds for a rig
+ * @param cables : number of cables
+ */
+void Decimator::reserve(size_t cables)
+{
+    low.reserve(cables);
+    high.reserve(cables);
+}
+
+/**
+ * @brief Decimator::decimate keeps the samples needed to reconstruct the
+ *        cable lengths
+ * @param trajectory : the sampled command
+ * @param tolerance : largest reconstruction error of a cable length
+ * @param decimated : receives the kept samples
+ * @return the number of kept samples
+ */
+size_t Decimator::decimate(const TrajectoryBuffer &trajectory, double tolerance, TrajectoryBuffer &decimated)
+{
+    const size_t samples = trajectory.size();
+    const size_t cables = trajectory.cableCount();
+    decimated.resize(samples, cables);
+    if (samples <= 2)
+    {
+        for (size_t j = 0; j < samples; j++)
+            copySample(trajectory, j, decimated, j);
+        return samples;
+    }
+
+    const double *t = trajectory.t();
+    size_t kept = 0;
+    size_t anchor = 0;
+    copySample(trajectory, 0, decimated, kept++);
+    low.assign(cables, -std::numeric_limits<double>::infinity());
+    high.assign(cables, std::numeric_limits<double>::infinity());
+
+    for (size_t j = anchor + 1; j < samples; j++)
+    {
+        const double dt = t[j] - t[anchor];
+        bool inside = dt > 0;
+        for (size_t c = 0; c < cables && inside; c++)
+        {
+            double slope = (trajectory.cable(c)[j] - trajectory.cable(c)[anchor]) / dt;
+            inside = low[c] <= slope && slope <= high[c];
+        }
+        if (!inside)
+        {
+            //j - 1 was a valid end, it becomes the next anchor
+            anchor = j - 1;
+            copySample(trajectory, anchor, decimated, kept++);
+            std::fill(low.begin(), low.end(), -std::numeric_limits<double>::infinity());
+            std::fill(high.begin(), high.end(), std::numeric_limits<double>::infinity());
+        }
+        const double span = t[j] - t[anchor];
+        if (span <= 0)
+            continue;
+        for (size_t c = 0; c < cables; c++)
+        {
+            double rise = trajectory.cable(c)[j] - trajectory.cable(c)[anchor];
+            low[c] = std::max(low[c], (rise - tolerance) / span);
+            high[c] = std::min(high[c], (rise + tolerance) / span);
+        }
+    }
+    copySample(trajectory, samples - 1, decimated, kept++);
+    decimated.resize(kept);
+    return kept;
+}
+
+/**
+ * @brief reconstruct decodes a decimated command
+ * @param decimated : the kept samples
+ * @param full : the times to be reconstructed in t(), receives the other columns
+ */
+void reconstruct(const TrajectoryBuffer &decimated, TrajectoryBuffer &full)
+{
+    const size_t kept = decimated.size();
+    const double *dt = decimated.t();
+    size_t k = 0;
+    for (size_t j = 0; j < full.size() && kept > 0; j++)
+    {
+        const double t = full.t()[j];
+        while (k + 2 < kept && dt[k + 1] <= t)
+            k++;
+        const size_t next = kept > 1 ? k + 1 : k;
+        const double span = dt[next] - dt[k];
+        const double w = span > 0 ? std::min(std::max((t - dt[k]) / span, 0.0), 1.0) : 0;
+        full.x()[j] = decimated.x()[k] + w * (decimated.x()[next] - decimated.x()[k]);
+        full.y()[j] = decimated.y()[k] + w * (decimated.y()[next] - decimated.y()[k]);
+        full.z()[j] = decimated.z()[k] + w * (decimated.z()[next] - decimated.z()[k]);
+        for (size_t c = 0; c < full.cableCount(); c++)
+            full.cable(c)[j] = decimated.cable(c)[k] + w * (decimated.cable(c)[next] - decimated.cable(c)[k]);
+    }
+}
+
+/**
+ * @brief maxCableError compares the cable lengths of two buffers
+ */
+double maxCableError(const TrajectoryBuffer &a, const TrajectoryBuffer &b)
+{
+    double error = 0;
+    for (size_t c = 0; c < std::min(a.cableCount(), b.cableCount()); c++)
+        for (size_t j = 0; j < std::min(a.size(), b.size()); j++)
+            error = std::max(error, std::fabs(a.cable(c)[j] - b.cable(c)[j]));
+    return error;
+}
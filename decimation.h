@@ -0,0 +1,43 @@
+#ifndef DECIMATION_H
+#define DECIMATION_H
+
+#include "trajectorybuffer.h"
+#include <vector>
+using std::vector;
+
+/**
+ * Error-bounded decimation of a sampled command. Only the samples needed
+ * to reconstruct every cable length by linear interpolation within the
+ * tolerance are kept; all columns share the kept time points, so the result
+ * is an ordinary TrajectoryBuffer for the writers. The first and the last
+ * sample of a command are always kept.
+ *
+ * The kept samples are chosen with a cone (swing door) per cable: starting
+ * at the last kept sample, a sample can end the current line as long as the
+ * chord to it passes every sample in between within the tolerance, for all
+ * cables at once. The cone bounds are kept between commands, so a warm
+ * Decimator does not allocate.
+ */
+class Decimator
+{
+public:
+    void reserve(size_t cables);
+    size_t decimate(const TrajectoryBuffer &trajectory, double tolerance, TrajectoryBuffer &decimated);
+
+private:
+    vector<double> low, high;   //slope bounds of the cone per cable
+};
+
+/**
+ * Decoder: fills the columns of `full` at its times (full.t(), set by the
+ * caller) by linear interpolation of the decimated command.
+ */
+void reconstruct(const TrajectoryBuffer &decimated, TrajectoryBuffer &full);
+
+/**
+ * Largest difference between the cable lengths of two buffers with the
+ * same samples.
+ */
+double maxCableError(const TrajectoryBuffer &a, const TrajectoryBuffer &b);
+
+#endif // DECIMATION_H
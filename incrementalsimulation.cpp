@@ -0,0 +1,277 @@
+#include "incrementalsimulation.h"
+#include "cablekinematics.h"
+#include "profiler.h"
+#include <stdexcept> //std::out_of_range
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+/**
+ * @brief endTime time at which the camera is at rest again after a command
+ */
+double endTime(const CommandDecision &decision)
+{
+    return decision.succeeded ? decision.startTime + decision.executionTime
+                              : decision.cameraStopTime;
+}
+
+}
+
+/**
+ * @brief PatchedRange::report one line per edit
+ */
+void PatchedRange::report(std::ostream &out) const
+{
+    out << "instruction " << instruction << ": ";
+    if (first < 0)
+        out << "no command changed";
+    else
+        out << "recomputed commands " << first << ".." << last << " (" << recomputed
+            << " executed), output " << from << "s.." << to << "s"
+            << (converged ? ", converged" : ", up to the end");
+    out << ", " << seconds * 1e3 << " ms" << std::endl;
+}
+
+/**
+ * @brief IncrementalSimulation::IncrementalSimulation
+ * @param fileName_ : the input file for the simulation
+ */
+IncrementalSimulation::IncrementalSimulation(const string &fileName_) : ISimulation(fileName_)
+{
+    iodata.setPatchableOutput(true);
+    for (int i = 0; i < iodata.getInstructionsSize(); i++)
+        times.push_back(iodata.getInstruction(i,0));
+}
+
+IncrementalSimulation::~IncrementalSimulation()
+{
+    iodata.closeOutput();
+}
+
+/**
+ * @brief IncrementalSimulation::simulate runs every command again and writes
+ *        the output, which stays open for the edits
+ */
+void IncrementalSimulation::simulate()
+{
+    iodata.closeOutput();
+    executed.clear();
+    recompute(0, -1);
+    writeResults(0, executed.size());
+    iodata.flushOutput();
+    observer->flush();
+}
+
+/**
+ * @brief IncrementalSimulation::executeCommand decides command i entered at
+ *        currentStartTime and keeps the decision in `current`. The samples
+ *        are generated by writeResults().
+ * @param i : command level
+ */
+void IncrementalSimulation::executeCommand(int i)
+{
+    current = CommandDecision();
+    const int count = iodata.getInstructionsSize();
+    if (i < 0 || i >= count - 1)
+        return;
+    try
+    {
+        init(i);
+        bool hasAfterNext = i + 2 < count - 1;
+        CommandDecision decision = decideCommand(profile(i), i, currentStartTime, times[i+1],
+                                                 hasAfterNext ? &times[i+2] : nullptr);
+        calculateStagesVector(i);
+        currentExecutionTime = t_c;
+        nextStartTime = decision.nextStartTime;
+        CommandEvent event;
+        event.command = i;
+        event.from = iodata.getInstruction(i);
+        event.from[0] = currentStartTime;
+        event.to = iodata.getInstruction(i + 1);
+        event.executionTime = t_c;
+        event.stagesVector = stagesVector;
+        if (decision.succeeded)
+        {
+            observer->commandSucceeded(event);
+            SPIDERCAM_COUNT(CommandsSucceeded, 1);
+        }
+        else
+        {
+            observer->commandFailed(event);
+            observer->cameraStopped(event, decision.cameraStopTime);
+            SPIDERCAM_COUNT(CommandsFailed, 1);
+            if (decision.rescheduled)
+            {
+                observer->commandRescheduled(i + 2, decision.cameraStopTime);
+                SPIDERCAM_COUNT(CommandsSkipped, 1);
+            }
+        }
+        current = decision;
+    }
+    catch (const std::out_of_range &oor)
+    {
+        std::cerr << "Out of Range error: " << oor.what() << std::endl;
+    }
+}
+
+/**
+ * @brief IncrementalSimulation::setInstruction replaces an instruction and
+ *        runs again the commands it can change
+ * @param i : instruction level, 1 for the first instruction of the file
+ * @param instruction : time, x, y, z
+ * @return the recomputed commands, whose samples replace the old ones in the
+ *         output of simulate()
+ */
+PatchedRange IncrementalSimulation::setInstruction(int i, const array<double, 4> &instruction)
+{
+    const int count = iodata.getInstructionsSize();
+    if (i < 1 || i >= count)
+    {
+        std::cerr << "no instruction " << i << std::endl;
+        return PatchedRange();
+    }
+    iodata.setInstruction(i) = instruction;
+    times[i] = instruction[0];
+
+    const CableKinematics kinematics(iodata);
+    for (int c = i - 1; c <= i && c + 1 < count; c++)
+    {
+        init(c);
+        profiles[c] = kinematics.profile(currentStartPoint, currentEndPoint);
+    }
+
+    //command i-2 is the first one that reads the edited instruction
+    vector<CommandDecision>::const_iterator first =
+        std::lower_bound(executed.begin(), executed.end(), i - 2,
+                         [](const CommandDecision &d, int command) { return d.command < command; });
+    const size_t index = first - executed.begin();
+    const size_t segment = std::count_if(executed.cbegin(), first,
+                                         [](const CommandDecision &d) { return d.succeeded; });
+    PatchedRange range = recompute(index, i);
+
+    //the kept commands after a converged range stay where they are if the
+    //writer can replace segments, otherwise they are written again
+    if (iodata.replaceOutput(segment, range.replacedSegments))
+        writeResults(index, range.recomputed);
+    else
+        writeResults(index, executed.size() - index);
+    iodata.flushOutput();
+    return range;
+}
+
+/**
+ * @brief IncrementalSimulation::recompute runs the schedule again from the
+ *        executed command `first` until it joins the old schedule after the
+ *        edited instruction
+ * @param first : index in the executed commands, the ones before are kept
+ * @param edited : the edited instruction level, -1 to run up to the end
+ */
+PatchedRange IncrementalSimulation::recompute(size_t first, int edited)
+{
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    const int count = iodata.getInstructionsSize();
+    PatchedRange range;
+    range.instruction = edited;
+    range.from = std::numeric_limits<double>::infinity();
+    range.to = -range.from;
+
+    vector<CommandDecision> old(executed.begin() + first, executed.end());
+    executed.resize(first);
+
+    int i = 0;
+    double entry = count > 0 ? times[0] : 0;
+    if (!executed.empty())
+    {
+        const CommandDecision &previous = executed.back();
+        i = previous.next;
+        entry = previous.rescheduled ? previous.cameraStopTime : (i >= 0 ? times[i] : 0);
+    }
+
+    size_t k = 0;
+    while (i >= 0 && i < count - 1)
+    {
+        for (; k < old.size() && old[k].command < i; k++)
+        {
+            range.from = std::min(range.from, old[k].startTime);
+            range.to = std::max(range.to, endTime(old[k]));
+            range.replacedSegments += old[k].succeeded;
+        }
+        if (edited >= 0 && i > edited && k < old.size() &&
+            old[k].command == i && old[k].startTime == entry)
+        {
+            range.converged = true;
+            break;
+        }
+
+        currentStartTime = entry;
+        executeCommand(i);
+        const CommandDecision &decision = current;
+        if (range.first < 0)
+            range.first = i;
+        range.last = i;
+        range.recomputed++;
+        range.from = std::min(range.from, decision.startTime);
+        range.to = std::max(range.to, endTime(decision));
+
+        i = decision.next;
+        entry = decision.rescheduled ? decision.cameraStopTime : (i >= 0 && i < count ? times[i] : 0);
+        executed.push_back(current);
+    }
+
+    if (range.converged)
+        executed.insert(executed.end(), old.begin() + k, old.end());
+    else
+        for (; k < old.size(); k++)
+        {
+            range.from = std::min(range.from, old[k].startTime);
+            range.to = std::max(range.to, endTime(old[k]));
+            range.replacedSegments += old[k].succeeded;
+        }
+
+    if (range.from > range.to)
+        range.from = range.to = 0;
+    range.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return range;
+}
+
+/**
+ * @brief IncrementalSimulation::writeResults samples the succeeded commands
+ *        among the executed ones [first, first + count) and writes them
+ */
+void IncrementalSimulation::writeResults(size_t first, size_t count)
+{
+    for (size_t k = first; k < first + count; k++)
+    {
+        const CommandDecision &decision = executed[k];
+        if (!decision.succeeded)
+            continue;
+        const int i = decision.command;
+        calculateStagesVector(i);
+        calculateTimeIntervals(i);
+        currentLine_G(i);
+        calculateLengthSteelCables(i);
+        iodata.output(trajectory, decision.startTime, i);
+        SPIDERCAM_COUNT(Samples, trajectory.size());
+    }
+}
+
+/**
+ * @brief IncrementalSimulation::closeOutput completes the output files, the
+ *        binary file can only be read after it
+ */
+void IncrementalSimulation::closeOutput()
+{
+    iodata.closeOutput();
+}
+
+/**
+ * @brief IncrementalSimulation::results the decisions of the executed
+ *        commands of the run
+ */
+const vector<CommandDecision> &IncrementalSimulation::results() const
+{
+    return executed;
+}
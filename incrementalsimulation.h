@@ -0,0 +1,68 @@
+#ifndef INCREMENTALSIMULATION_H
+#define INCREMENTALSIMULATION_H
+
+#include "isimulation.h"
+#include "commandscheduler.h"
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include <array>
+
+using std::string;
+using std::array;
+using std::vector;
+
+/**
+ * @brief The PatchedRange struct, what an edit recomputed
+ */
+struct PatchedRange
+{
+    int instruction{-1};        //edited instruction level
+    int first{-1}, last{-1};    //first and last recomputed command, -1: none
+    size_t recomputed{};        //executed commands evaluated again
+    double from{}, to{};        //time span of the replaced output
+    bool converged{};           //the old schedule was joined again before the end
+    size_t replacedSegments{};  //succeeded commands of the old schedule dropped
+    double seconds{};
+
+    void report(std::ostream &out) const;
+};
+
+/**
+ * @brief The IncrementalSimulation class
+ *
+ * Keeps the decision of every executed command; the samples follow from
+ * the profile and the start time and are generated again whenever they are
+ * written, so the run holds no samples in memory. A command only depends on
+ * its profile, the time it is entered with and the start times of the two
+ * following instructions, so editing instruction j can change the decisions
+ * from command j-2 on. setInstruction() runs the schedule again from the
+ * first executed command of that window and stops as soon as it enters a
+ * command after j with the same start time as before: from there on the
+ * old results are still valid and are kept. Blending is not supported.
+ *
+ * simulate() writes the output once and keeps it open; every edit patches
+ * it with the recomputed commands. closeOutput() completes the files.
+ */
+class IncrementalSimulation : public ISimulation
+{
+public:
+    explicit IncrementalSimulation(const string &fileName);
+    ~IncrementalSimulation();
+    void simulate() override;
+    void executeCommand(int i) override;
+    PatchedRange setInstruction(int i, const array<double,4> &instruction);
+    void closeOutput();
+    const vector<CommandDecision> &results() const;
+
+private:
+    PatchedRange recompute(size_t first, int edited);
+    void writeResults(size_t first, size_t count);
+
+    vector<double> times;               //start times as given, rescheduling does not change them
+    vector<CommandDecision> executed;   //in the order of the run, startTime is the time
+                                        //the command was entered with
+    CommandDecision current;            //decision of the last executeCommand()
+};
+
+#endif // INCREMENTALSIMULATION_H
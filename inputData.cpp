@@ -1,9 +1,19 @@
 #include "inputData.h"
+#include "profiler.h"
 using std::ifstream;
 #include <iostream>
 #include <fstream>
 #include <sstream>      // std::stringstream
 #include <stdexcept>    // std::out_of_range
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <cctype>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 //ios::exceptions
 
 using std::cout;
@@ -39,6 +49,27 @@ int IOData::getFreq() const
     return freq;
 }
 
+int IOData::getJmax() const
+{
+    return jmax;
+}
+
+/**
+ * @brief IOData::getMotionLimits the limits the command profiles are built from
+ */
+MotionLimits IOData::getMotionLimits() const
+{
+    return {static_cast<double>(vmax), static_cast<double>(amax), static_cast<double>(jmax), motion};
+}
+
+/**
+ * @brief IOData::setMotionProfile selects the shape of the profiles of the run
+ */
+void IOData::setMotionProfile(MotionProfile profile)
+{
+    motion = profile;
+}
+
 double IOData::getInstruction(int i, int j) const
 {
     return instructions.at(i).at(j);
@@ -74,6 +105,55 @@ array<double, 3> IOData::getDim() const
     return dim;
 }
 
+/**
+ * @brief IOData::getAnchors the anchorage points of the steel cables
+ * @return the anchors of the input file, the top corners of the arena if
+ *         the file has no anchor directive
+ */
+AnchorPoints IOData::getAnchors() const
+{
+    return anchors.empty() ? cornerAnchors(dim) : anchors;
+}
+
+/**
+ * @brief IOData::addAnchor adds a winch to the rig, at most maxAnchors
+ * @param anchor : anchorage point of the cable
+ */
+void IOData::addAnchor(const array<double, 3> &anchor)
+{
+    if (anchors.size() < maxAnchors)
+        anchors.push_back(anchor);
+    else
+        std::cerr << "anchor ignored, the rig has at most " << maxAnchors << " cables" << std::endl;
+}
+
+/**
+ * @brief IOData::getCableLimits shortest and longest length of the cables
+ *        the winch drums allow, {0, 0} without a `cable` directive
+ */
+array<double, 2> IOData::getCableLimits() const
+{
+    return cableLimits;
+}
+
+/**
+ * @brief IOData::getWinchLimits largest rope speed and acceleration of the
+ *        winches, 0 for no limit
+ */
+array<double, 2> IOData::getWinchLimits() const
+{
+    return winchLimits;
+}
+
+/**
+ * @brief IOData::getObstacles the boxes of the `obstacle` directives, two
+ *        opposite corners each
+ */
+const vector<array<double, 6>> &IOData::getObstacles() const
+{
+    return obstacles;
+}
+
 array<double, 3> IOData::getStart() const
 {
     return start;
@@ -106,6 +186,21 @@ void IOData::init(const vector<string> &dataVector){
                 amax=std::stoi(dataVector.at(i));
             else if (dataVector.at(0)=="freq")
                 freq=std::stoi(dataVector.at(i));
+            else if (dataVector.at(0)=="jmax")
+                jmax=std::stoi(dataVector.at(i));
+        }
+        if (dataVector.at(0)=="anchor")
+            addAnchor({std::stod(dataVector.at(1)), std::stod(dataVector.at(2)), std::stod(dataVector.at(3))});
+        else if (dataVector.at(0)=="cable")
+            cableLimits = {std::stod(dataVector.at(1)), std::stod(dataVector.at(2))};
+        else if (dataVector.at(0)=="winch")
+            winchLimits = {std::stod(dataVector.at(1)), std::stod(dataVector.at(2))};
+        else if (dataVector.at(0)=="obstacle")
+        {
+            array<double,6> box;
+            for (size_t k = 0; k < box.size(); k++)
+                box[k] = std::stod(dataVector.at(k + 1));
+            obstacles.push_back(box);
         }
         if(isdigit(dataVector.at(0)[0])){
             array<double,4>lineData;
@@ -121,31 +216,95 @@ void IOData::init(const vector<string> &dataVector){
 }
 
 /**
- * @brief Simulation::output generates the 2 output files of the simulation
- * @param datavector :
+ * @brief IOData::setOutputFormat selects the output of the next run
+ * @param format : text files (_1.out/_2.out) or a binary .traj file
+ * @param type : sample type of the binary file
+ * @param scale : stored units per unit of the fixed32 samples
+ */
+void IOData::setOutputFormat(OutputFormat format, trajectoryformat::SampleType type, double scale)
+{
+    closeOutput();
+    outputFormat = format;
+    sampleType = type;
+    fixedScale = scale;
+}
+
+/**
+ * @brief IOData::setDecimation writes only the samples needed to reconstruct
+ *        the cable lengths by linear interpolation, see decimation.h
+ * @param tolerance : largest reconstruction error, 0 writes every sample
+ */
+void IOData::setDecimation(double tolerance)
+{
+    decimationTolerance = tolerance;
+}
+
+/**
+ * @brief IOData::setPatchableOutput opens the next output files so that
+ *        replaceOutput() can patch them, which costs memory per command
+ */
+void IOData::setPatchableOutput(bool patchable)
+{
+    closeOutput();
+    patchableOutput = patchable;
+}
+
+/**
+ * @brief IOData::reserveOutput sizes the output buffers for the largest
+ *        command of the run, so that writing does not allocate
+ * @param samples : samples of the largest command
+ * @param commands : number of commands
  */
-void IOData::output(const vector<vector<double>> &dataVector)
+void IOData::reserveOutput(size_t samples, size_t commands)
 {
-    string file_out1{fileName+"_1.out"};
-    std::ofstream ofs_file_out1(file_out1);
+    reservedSamples = samples;
+    reservedCommands = commands;
+    decimated.reserve(samples, getAnchors().size());
+    decimator.reserve(getAnchors().size());
+    if (writer)
+        writer->reserve(samples, commands);
+}
 
-    ofs_file_out1.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+/**
+ * @brief IOData::outputBufferGrowths times the buffer of the decimated
+ *        samples grew
+ */
+size_t IOData::outputBufferGrowths() const
+{
+    return decimated.allocations();
+}
+
+/**
+ * @brief IOData::output appends a sampled command to the output files of the
+ *        simulation. The files are opened by the first command of a run.
+ * @param trajectory : the sampled command
+ * @param startTime : start time of the command
+ * @param command : the command level
+ */
+void IOData::output(const TrajectoryBuffer &trajectory, double startTime, int command)
+{
+    SPIDERCAM_PROFILE_SCOPE(Output);
     try
     {
-        if (ofs_file_out1)
+        if (!writer)
         {
-            for (const vector<double> &element : dataVector)
-            {
-                std::string delim = "";
-                for (auto temp : element)
-                {
-                    ofs_file_out1 <<std::showpoint<<delim << temp;
-                    delim = ", ";
-                }
-                ofs_file_out1 << std::endl;
-            }
-            ofs_file_out1.close();
+            if (outputFormat == OutputFormat::Binary)
+                writer.reset(new BinaryTrajectoryWriter(fileName, dim, freq, vmax, amax, sampleType,
+                                                        trajectory.cableCount(), fixedScale));
+            else
+                writer.reset(new TextTrajectoryWriter(fileName, dim));
+            if (patchableOutput)
+                writer->enablePatching();
+            writer->reserve(reservedSamples, reservedCommands);
+        }
+        const TrajectoryBuffer *samples = &trajectory;
+        if (decimationTolerance > 0)
+        {
+            decimator.decimate(trajectory, decimationTolerance, decimated);
+            samples = &decimated;
         }
+        writer->writeSegment(*samples, startTime, command);
+        SPIDERCAM_COUNT(SamplesWritten, samples->size());
     }
     catch (std::ofstream::failure &e)
     {
@@ -154,54 +313,65 @@ void IOData::output(const vector<vector<double>> &dataVector)
 }
 
 /**
- * @brief Simulation::output generates the 2 output files of the simulation
- * @param : vector_t
- * @param : dataVector
+ * @brief IOData::setFileName base name of the output files
  */
-void IOData::output(const vector<double> &vector_t,
-                    const vector<vector<double>> &dataVector)
+void IOData::setFileName(const string &fileName_)
 {
-    string file_out2{fileName+"_2.out"};
-    std::ofstream ofs_file_out2(file_out2);
+    closeOutput();
+    fileName = fileName_;
+}
 
-    ofs_file_out2.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+/**
+ * @brief IOData::replaceOutput lets the next output() calls replace the
+ *        written segments [first, first + count) of a patchable output
+ * @return false if every segment from first on has to be written again
+ */
+bool IOData::replaceOutput(size_t first, size_t count)
+{
     try
     {
-        if (ofs_file_out2)
-        {
-            std::string delim = "";
-            for (double element : dim)
-            {
-                ofs_file_out2 <<std::showpoint<<delim << element;
-                delim = ", ";
-            }
-            ofs_file_out2 << std::endl;
+        return writer && writer->replaceSegments(first, count);
+    }
+    catch (std::ofstream::failure &e)
+    {
+        std::cerr << e.what() << std::endl;
+    }
+    return false;
+}
 
-            delim = "";
-            for (double element : vector_t)
-            {
-                ofs_file_out2 <<std::showpoint<<delim << element;
-                delim = ", ";
-            }
-            ofs_file_out2 << std::endl;
-
-            for (const vector<double> &element : dataVector)
-            {
-                delim = "";
-                for (double temp : element)
-                {
-                    ofs_file_out2 <<std::showpoint<<delim << temp;
-                    delim = ", ";
-                }
-                ofs_file_out2 << std::endl;
-            }
-            ofs_file_out2.close();
-        }
+/**
+ * @brief IOData::flushOutput hands everything written so far to the files
+ */
+void IOData::flushOutput()
+{
+    try
+    {
+        if (writer)
+            writer->flush();
+    }
+    catch (std::ofstream::failure &e)
+    {
+        std::cerr << e.what() << std::endl;
+    }
+}
+
+/**
+ * @brief IOData::closeOutput flushes and closes the output files of the run.
+ *        The next call of output() starts new files.
+ */
+void IOData::closeOutput()
+{
+    SPIDERCAM_PROFILE_SCOPE(Output);
+    try
+    {
+        if (writer)
+            writer->close();
     }
     catch (std::ofstream::failure &e)
     {
         std::cerr << e.what() << std::endl;
     }
+    writer.reset();
 }
 
 /**
@@ -224,11 +394,214 @@ std::string IOData::process(std::string const &s)
 }
 
 /**
- * @brief Read a file and extract its content
+ * @brief Read a file and extract its content. The file is mapped into
+ *        memory (or read in one block) and parsed in place by parse().
  * 
  * @param fileName : the file to be read
+ * @throws std::runtime_error if the file cannot be opened
  */
 void IOData::einlesen(const string &fileName)
+{
+    SPIDERCAM_PROFILE_SCOPE(Parse);
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || ::fstat(fd, &info) != 0)
+    {
+        string error = std::strerror(errno);
+        if (fd >= 0)
+            ::close(fd);
+        throw std::runtime_error("cannot read " + fileName + ": " + error);
+    }
+
+    size_t size = static_cast<size_t>(info.st_size);
+    void *mapping = size > 0 ? ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    if (mapping != MAP_FAILED)
+    {
+        ::madvise(mapping, size, MADV_SEQUENTIAL);
+        parse(static_cast<const char *>(mapping), size);
+        ::munmap(mapping, size);
+    }
+    else
+    {
+        vector<char> block;
+        char chunk[1 << 16];
+        ssize_t n;
+        while ((n = ::read(fd, chunk, sizeof(chunk))) > 0)
+            block.insert(block.end(), chunk, chunk + n);
+        parse(block.data(), block.size());
+    }
+    ::close(fd);
+}
+
+/**
+ * @brief IOData::parse extracts the content of an input file held in memory
+ * @param data : content of the file
+ * @param size : size of the content
+ */
+void IOData::parse(const char *data, size_t size)
+{
+    const char *end = data + size;
+    instructions.reserve(instructions.size() + std::count(data, end, '\n') + 2);
+    while (data < end)
+    {
+        const char *eol = static_cast<const char *>(std::memchr(data, '\n', end - data));
+        if (!eol)
+            eol = end;
+        array<double,4> instruction;
+        if (parseLine(data, eol, instruction))
+            instructions.push_back(instruction);
+        data = eol + 1;
+    }
+}
+
+namespace {
+
+inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/**
+ * @brief nextToken moves first to the next token and returns its end
+ */
+inline const char *nextToken(const char *&first, const char *last)
+{
+    while (first < last && isBlank(*first))
+        first++;
+    const char *tokenEnd = first;
+    while (tokenEnd < last && !isBlank(*tokenEnd))
+        tokenEnd++;
+    return tokenEnd;
+}
+
+inline bool keyword(const char *first, const char *last, const char *word)
+{
+    size_t length = std::strlen(word);
+    return static_cast<size_t>(last - first) == length && std::memcmp(first, word, length) == 0;
+}
+
+/**
+ * @brief readIntegers reads up to count integer values, like init() does
+ */
+template <class T>
+void readIntegers(const char *first, const char *last, T *values, size_t count)
+{
+    for (size_t k = 0; k < count; k++)
+    {
+        const char *tokenEnd = nextToken(first, last);
+        if (first == tokenEnd)
+            return;
+        int value = 0;
+        std::from_chars(first, tokenEnd, value);
+        values[k] = value;
+        first = tokenEnd;
+    }
+}
+
+/**
+ * @brief readDoubles reads up to count floating point values
+ * @return the number of values read
+ */
+size_t readDoubles(const char *first, const char *last, double *values, size_t count)
+{
+    for (size_t k = 0; k < count; k++)
+    {
+        const char *tokenEnd = nextToken(first, last);
+        if (first == tokenEnd)
+            return k;
+        std::from_chars(first, tokenEnd, values[k]);
+        first = tokenEnd;
+    }
+    return count;
+}
+
+}
+
+/**
+ * @brief IOData::parseLine interprets one line of an input file:
+ *        a directive (dim, start, vmax, amax, jmax, freq, anchor,
+ *        cable, winch, obstacle) is applied, an
+ *        instruction (t x y z) is returned. Comments start with '#'.
+ * @param first : start of the line
+ * @param last : end of the line, without the line feed
+ * @param instruction : receives the instruction
+ * @return true if the line is an instruction
+ */
+bool IOData::parseLine(const char *first, const char *last, array<double,4> &instruction)
+{
+    const char *comment = static_cast<const char *>(std::memchr(first, '#', last - first));
+    if (comment)
+        last = comment;
+
+    const char *tokenEnd = nextToken(first, last);
+    if (first == tokenEnd)
+        return false;
+
+    if (std::isdigit(static_cast<unsigned char>(*first)))
+    {
+        instruction = array<double,4>{};
+        for (size_t k = 0; k < instruction.size() && first < tokenEnd; k++)
+        {
+            std::from_chars(first, tokenEnd, instruction[k]);
+            first = tokenEnd;
+            tokenEnd = nextToken(first, last);
+        }
+        return true;
+    }
+    else if (keyword(first, tokenEnd, "dim"))
+        readIntegers(tokenEnd, last, dim.data(), dim.size());
+    else if (keyword(first, tokenEnd, "start"))
+        readIntegers(tokenEnd, last, start.data(), start.size());
+    else if (keyword(first, tokenEnd, "vmax"))
+        readIntegers(tokenEnd, last, &vmax, 1);
+    else if (keyword(first, tokenEnd, "amax"))
+        readIntegers(tokenEnd, last, &amax, 1);
+    else if (keyword(first, tokenEnd, "freq"))
+        readIntegers(tokenEnd, last, &freq, 1);
+    else if (keyword(first, tokenEnd, "jmax"))
+        readIntegers(tokenEnd, last, &jmax, 1);
+    else if (keyword(first, tokenEnd, "anchor"))
+    {
+        array<double,3> anchor{};
+        if (readDoubles(tokenEnd, last, anchor.data(), anchor.size()) == anchor.size())
+            addAnchor(anchor);
+        else
+            std::cerr << "anchor needs x y z" << '\n';
+    }
+    else if (keyword(first, tokenEnd, "cable"))
+    {
+        array<double,2> limits{};
+        if (readDoubles(tokenEnd, last, limits.data(), limits.size()) == limits.size())
+            cableLimits = limits;
+        else
+            std::cerr << "cable needs min max" << '\n';
+    }
+    else if (keyword(first, tokenEnd, "winch"))
+    {
+        array<double,2> limits{};
+        if (readDoubles(tokenEnd, last, limits.data(), limits.size()) == limits.size())
+            winchLimits = limits;
+        else
+            std::cerr << "winch needs vmax amax" << '\n';
+    }
+    else if (keyword(first, tokenEnd, "obstacle"))
+    {
+        array<double,6> box{};
+        if (readDoubles(tokenEnd, last, box.data(), box.size()) == box.size())
+            obstacles.push_back(box);
+        else
+            std::cerr << "obstacle needs x0 y0 z0 x1 y1 z1" << '\n';
+    }
+    return false;
+}
+
+/**
+ * @brief Read a file and extract its content with string streams.
+ *        Reference implementation of einlesen(), kept for comparison.
+ * 
+ * @param fileName : the file to be read
+ */
+void IOData::einlesenStream(const string &fileName)
 {
     ifstream file_in(fileName);
     file_in.exceptions ( std::ifstream::failbit | std::ifstream::badbit );
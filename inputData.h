@@ -4,6 +4,12 @@
 #include <string>
 #include <vector>
 #include <array>
+#include <memory>
+#include "trajectorybuffer.h"
+#include "cablekernel.h"
+#include "segmentprofile.h"
+#include "trajectorywriter.h"
+#include "decimation.h"
 
 using std::string;
 using std::array;
@@ -21,16 +27,35 @@ class IOData {
 string fileName;
 array<double,3>dim{};
 array<double,3>start{};
+AnchorPoints anchors;      //from `anchor x y z` directives, empty for the corners
+array<double,2>cableLimits{};               //drum limits `cable min max`, max 0: none
+array<double,2>winchLimits{};               //rope speed and acceleration `winch vmax amax`
+vector<array<double,6>>obstacles;           //boxes `obstacle x0 y0 z0 x1 y1 z1`
 int vmax{}, amax{}, freq{};
+int jmax{};                 //0: no jerk limit
+MotionProfile motion{MotionProfile::Trapezoid};
 vector<array<double,4>>instructions;
+std::unique_ptr<TrajectoryWriter>writer;
+OutputFormat outputFormat{OutputFormat::Text};
+trajectoryformat::SampleType sampleType{trajectoryformat::SampleType::Float64};
+double fixedScale{trajectoryformat::defaultFixedScale};    //of the fixed32 samples
+double decimationTolerance{0};  //0: every sample is written
+TrajectoryBuffer decimated;     //kept samples of the current command
+Decimator decimator;
+size_t reservedSamples{0}, reservedCommands{0};
+bool patchableOutput{false};    //the writers support replaceOutput()
 
 public:
+IOData() = default;
 explicit IOData(const string &fileName);
 
 string getFileName()const;
 int getVmax()const;
 int getAmax()const;
 int getFreq()const;
+int getJmax()const;
+MotionLimits getMotionLimits()const;
+void setMotionProfile(MotionProfile profile);
 
 double getInstruction(int i, int j)const;
 double& setInstruction(int i, int j);
@@ -41,14 +66,31 @@ int getInstructionsSize()const;
 
 array<double,3>getDim()const;
 array<double,3>getStart()const;
+AnchorPoints getAnchors()const;
+void addAnchor(const array<double,3> &anchor);
+array<double,2>getCableLimits()const;
+array<double,2>getWinchLimits()const;
+const vector<array<double,6>> &getObstacles()const;
 
 vector<string> split(const string& s, char delimiter);
 void einlesen(const string &fileName);
+void einlesenStream(const string &fileName);
+void parse(const char *data, size_t size);
+bool parseLine(const char *first, const char *last, array<double,4> &instruction);
+void setFileName(const string &fileName);
 std::string process(std::string const& s);
 void init(const vector<string> &dataVector);
-void output(const vector<vector<double>> &dataVector);
-void output(const vector<double> &vector_t,
-            const vector<vector<double>> &dataVector);
+void setOutputFormat(OutputFormat format,
+                     trajectoryformat::SampleType type = trajectoryformat::SampleType::Float64,
+                     double scale = trajectoryformat::defaultFixedScale);
+void setDecimation(double tolerance);
+void setPatchableOutput(bool patchable);
+void reserveOutput(size_t samples, size_t commands);
+size_t outputBufferGrowths()const;
+void output(const TrajectoryBuffer &trajectory, double startTime, int command);
+bool replaceOutput(size_t first, size_t count);
+void flushOutput();
+void closeOutput();
 };
 
 #endif // INPUTDATA
@@ -4,6 +4,10 @@
 #include <iostream>
 #include <fstream>
 #include <cmath>
+#include <algorithm>
+#include "sampling.h"
+#include "profiler.h"
+#include "cablekinematics.h"
 
 /**
  * @brief Simulation::Simulation constructs the simulation class
@@ -11,7 +15,9 @@
  */
 ISimulation::ISimulation(const string &fileName_) :
     fileName(fileName_),
-    iodata(IOData(fileName_)),
+    iodata(fileName_),
+    defaultObserver(new VerboseTextSink(std::cout)),
+    observer(defaultObserver.get()),
     currentStartTime(0),
     nextStartTime(0),
     currentExecutionTime(0)
@@ -25,11 +31,13 @@ ISimulation::ISimulation(const string &fileName_) :
  */
 void ISimulation::calculateStagesVector(int i)
 {
-    t_a = iodata.getVmax() / iodata.getAmax();
-    st_a = (iodata.getAmax() / 2) * pow(t_a, 2);
-    t_b = t_a + ((calculateCurrentDelta(i) - 2 * st_a) / iodata.getVmax());
-    t_c = t_a + t_b;
-    stagesVector = {t_a, t_b, t_c};
+    SPIDERCAM_PROFILE_SCOPE(StagesVector);
+    const SegmentProfile &p = profile(i);
+    t_a = p.t_a;
+    st_a = p.s_a;
+    t_b = p.t_b;
+    t_c = p.t_c;
+    stagesVector = p.stagesVector();
 }
 
 /**
@@ -40,16 +48,7 @@ void ISimulation::calculateStagesVector(int i)
  */
 double ISimulation::calculateS_t(int i, double t)
 {
-    calculateStagesVector(i);
-    double result{};
-    if ((0 <= t) && (t <= t_a))
-        result = (iodata.getAmax() / 2) * pow(t, 2);
-    else if ((t_a <= t) && (t <= t_b))
-        result = st_a + iodata.getVmax() * (t - t_a);
-    else if ((t_b <= t) && (t <= t_c))
-        result = calculateCurrentDelta(i) - ((iodata.getAmax() / 2) * (pow((t - t_c), 2)));
-
-    return result;
+    return profile(i).distance(t);
 }
 
 /**
@@ -60,7 +59,7 @@ double ISimulation::calculateS_t(int i, double t)
  */
 double ISimulation::lambda(int i, double t)
 {
-    return calculateS_t(i, t) / calculateCurrentDelta(i);
+    return profile(i).lambda(t);
 }
 
 /**
@@ -70,10 +69,8 @@ double ISimulation::lambda(int i, double t)
  */
 void ISimulation::calculateTimeIntervals(int i)
 {
-    calculateStagesVector(i);
-    timeIntervals.clear();
-    for (int j = 0; j <= std::floor(t_c * iodata.getFreq()); j++)
-        timeIntervals.push_back((float)j / iodata.getFreq());
+    SPIDERCAM_PROFILE_SCOPE(TimeIntervals);
+    sampleTimeIntervals(trajectory, profile(i), iodata.getFreq());
 }
 
 /**
@@ -84,16 +81,7 @@ void ISimulation::calculateTimeIntervals(int i)
  */
 double ISimulation::currentVelocity(int i, double t)
 {
-    init(i);
-    double result;
-    if (0 <= t && t <= t_a)
-        result = iodata.getAmax() * t;
-    else if (t_a < t && t < t_b)
-        result = iodata.getVmax();
-    else
-        result = (iodata.getVmax() - iodata.getAmax()) * (t - t_a);
-
-    return result;
+    return profile(i).velocity(t);
 }
 
 /**
@@ -102,19 +90,9 @@ double ISimulation::currentVelocity(int i, double t)
  */
 void ISimulation::currentLine_G(int i)
 {
+    SPIDERCAM_PROFILE_SCOPE(LineSampling);
     init(i);
-    vector<double> element;
-    currentCameraPositions.clear();
-
-    for (size_t k = 0; k < currentStartPoint.size(); k++)
-    {
-        for (size_t j = 0; j < timeIntervals.size(); j++)
-        {
-            element.push_back(currentStartPoint[k] + lambda(i, timeIntervals.at(j)) * (currentEndPoint[k] - currentStartPoint[k]));
-        }
-        currentCameraPositions.push_back(element);
-        element.clear();
-    }
+    sampleLine(trajectory, profile(i), samplingThreads());
 }
 
 /**
@@ -135,61 +113,19 @@ void ISimulation::calculateCurrentCameraPositions(int i)
  */
 void ISimulation::calculateCurrentCameraPositions(int i, double t) {
     init(i);
-    for (size_t k = 0; k < currentStartPoint.size(); k++)
-        currentPosition.at(k)=(currentStartPoint[k] + lambda(i, t) * (currentEndPoint[k] - currentStartPoint[k]));
+    currentPosition = profile(i).position(t);
 }
 
 /**
  * @brief Simulation::calculateLengthSteelCables :
- *          The length of the steel cables for the spidercam
+ *          The length of the steel cables for the spidercam,
+ *          calculated from the positions sampled by currentLine_G(i)
  * @param i : the command level
  */
-void ISimulation::calculateLengthSteelCables(int i)
+void ISimulation::calculateLengthSteelCables(int)
 {
-    calculateCurrentCameraPositions(i);
-    vector<double> element;
-    double result;
-    lengthSteelCables.clear();
-
-    for (size_t j = 0; j < timeIntervals.size(); j++)
-    {
-        result = sqrt(std::pow(currentCameraPositions[0][j] - anchoragePoint_R1[0], 2) +
-                      std::pow(currentCameraPositions[1][j] - anchoragePoint_R1[1], 2) +
-                      std::pow(currentCameraPositions[2][j] - anchoragePoint_R1[2], 2));
-        element.push_back(result);
-    }
-    lengthSteelCables.push_back(element);
-    element.clear();
-
-    for (size_t j = 0; j < timeIntervals.size(); j++)
-    {
-        result = sqrt(std::pow(currentCameraPositions[0][j] - anchoragePoint_R2[0], 2) +
-                      std::pow(currentCameraPositions[1][j] - anchoragePoint_R2[1], 2) +
-                      std::pow(currentCameraPositions[2][j] - anchoragePoint_R2[2], 2));
-        element.push_back(result);
-    }
-    lengthSteelCables.push_back(element);
-    element.clear();
-
-    for (size_t j = 0; j < timeIntervals.size(); j++)
-    {
-        result = sqrt(std::pow(currentCameraPositions[0][j] - anchoragePoint_R3[0], 2) +
-                      std::pow(currentCameraPositions[1][j] - anchoragePoint_R3[1], 2) +
-                      std::pow(currentCameraPositions[2][j] - anchoragePoint_R3[2], 2));
-        element.push_back(result);
-    }
-    lengthSteelCables.push_back(element);
-    element.clear();
-
-    for (size_t j = 0; j < timeIntervals.size(); j++)
-    {
-        result = sqrt(std::pow(currentCameraPositions[0][j] - anchoragePoint_R4[0], 2) +
-                      std::pow(currentCameraPositions[1][j] - anchoragePoint_R4[1], 2) +
-                      std::pow(currentCameraPositions[2][j] - anchoragePoint_R4[2], 2));
-        element.push_back(result);
-    }
-    lengthSteelCables.push_back(element);
-    element.clear();
+    SPIDERCAM_PROFILE_SCOPE(CableLengths);
+    sampleCableLengths(trajectory, anchorPoints(), samplingThreads());
 }
 
 /**
@@ -199,12 +135,8 @@ void ISimulation::calculateLengthSteelCables(int i)
  */
 double ISimulation::calculateCurrentDelta(int i)
 {
-    double result{};
     init(i);
-    result = sqrt(std::pow(currentEndPoint[0] - currentStartPoint[0], 2) +
-                  std::pow(currentEndPoint[1] - currentStartPoint[1], 2) +
-                  std::pow(currentEndPoint[2] - currentStartPoint[2], 2));
-    return result;
+    return profile(i).delta;
 }
 
 /**
@@ -218,41 +150,109 @@ void ISimulation::init(int i)
     if ((size_t)i < iodata.getInstructionsSize() - 1)
         currentEndPoint = {iodata.getInstruction(i+1,1), iodata.getInstruction(i+1,2), iodata.getInstruction(i+1,3)};
 }
+
+/**
+ * @brief ISimulation::ioData the input data and output settings of the simulation
+ */
+IOData &ISimulation::ioData()
+{
+    return iodata;
+}
+
+/**
+ * @brief ISimulation::setObserver selects the receiver of the events
+ * @param observer_ : not owned, nullptr restores the verbose console report
+ */
+void ISimulation::setObserver(SimulationObserver *observer_)
+{
+    observer = observer_ ? observer_ : defaultObserver.get();
+}
+
+/**
+ * @brief ISimulation::anchorPoints the anchorage points of the steel cables
+ */
+const AnchorPoints &ISimulation::anchorPoints() const
+{
+    return anchors;
+}
+
+/**
+ * @brief ISimulation::setSamplingOptions threads used to sample long commands
+ */
+void ISimulation::setSamplingOptions(const SamplingOptions &options)
+{
+    sampling = options;
+}
+
+/**
+ * @brief ISimulation::samplingThreads threads for the current command
+ * @return 1 unless the command has more samples than the threshold
+ */
+unsigned ISimulation::samplingThreads() const
+{
+    return trajectory.size() > sampling.parallelThreshold ? sampling.threads : 1;
+}
+
+/**
+ * @brief ISimulation::profile the precomputed motion profile of a command
+ * @param i : the command level
+ * @return the profile built in init()
+ */
+const SegmentProfile &ISimulation::profile(int i) const
+{
+    return profiles.at(i);
+}
+
 /**
  * @brief Simulation::init Initialization of some constants
  */
 void ISimulation::init()
 {
-    t_a = iodata.getVmax() / iodata.getAmax();
+    t_a = static_cast<double>(iodata.getVmax()) / iodata.getAmax();
     t_b = t_c = st_a = 0;
     array<double, 4> startCommand = {0, iodata.getStart()[0], iodata.getStart()[1], iodata.getStart()[2]};
     iodata.insertInstruction(0, startCommand);
-    anchoragePoint_R1 = {0, 0, iodata.getDim().at(2)};
-    anchoragePoint_R2 = {iodata.getDim().at(0), 0, iodata.getDim().at(2)};
-    anchoragePoint_R3 = {0, iodata.getDim().at(1), iodata.getDim().at(2)};
-    anchoragePoint_R4 = {iodata.getDim().at(0), iodata.getDim().at(1), iodata.getDim().at(2)};
+    anchors = iodata.getAnchors();
+    trajectory.resize(0, anchors.size());
+    buildProfiles();
+}
+
+/**
+ * @brief ISimulation::buildProfiles derives the motion profile of every command
+ */
+void ISimulation::buildProfiles()
+{
+    const CableKinematics kinematics(iodata);
+    profiles.clear();
+    for (int i = 0; i + 1 < iodata.getInstructionsSize(); i++)
+    {
+        init(i);
+        profiles.push_back(kinematics.profile(currentStartPoint, currentEndPoint));
+    }
+    reserveBuffers();
 }
 
 /**
- * @brief Simulation::pointToString prints a point
- * @param point : Point to be printed
+ * @brief ISimulation::reserveBuffers sizes the per-command buffers from the
+ *        longest command (t_c * freq samples), so that commands do not
+ *        allocate during the run
  */
-void ISimulation::pointToString(const array<double, 3> &point)
+void ISimulation::reserveBuffers()
 {
-    std::cout << "[" << point[0] << ","
-              << point[1] << ","
-              << point[2] << "]" << std::endl;
+    double longest = 0;
+    for (const SegmentProfile &p : profiles)
+        longest = std::max(longest, p.t_c);
+    const size_t samples = static_cast<size_t>(std::floor(longest * iodata.getFreq())) + 1;
+    trajectory.reserve(samples, anchors.size());
+    iodata.reserveOutput(samples, profiles.size());
 }
 
 /**
- * @brief Simulation::commandToString prints a command to the screen
- * @param point : the command to be printed
+ * @brief ISimulation::setMotionProfile selects the shape of the profiles
+ *        and rebuilds them, to be called before simulate()
  */
-void ISimulation::commandToString(const std::array<double, 4> &command)
+void ISimulation::setMotionProfile(MotionProfile profile)
 {
-    std::cout << command[0] << "s"
-              << " at "
-              << "[" << command[1] << ","
-              << command[2] << ","
-              << command[3] << "]" << std::endl;
+    iodata.setMotionProfile(profile);
+    buildProfiles();
 }
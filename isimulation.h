@@ -2,6 +2,10 @@
 #define ISIMULATION_H
 
 #include "inputData.h"
+#include "segmentprofile.h"
+#include "trajectorybuffer.h"
+#include "cablekernel.h"
+#include "simulationevents.h"
 #include <string>
 #include <vector>
 #include <array>
@@ -10,6 +14,18 @@ using std::string;
 using std::array;
 using std::vector;
 
+/**
+ * @brief The SamplingOptions struct
+ *
+ * Commands with more samples than parallelThreshold are sampled on
+ * `threads` threads, each one taking a contiguous chunk of the samples.
+ */
+struct SamplingOptions
+{
+    unsigned threads{1};
+    size_t parallelThreshold{100000};
+};
+
 /**
  * @brief The ISimulation class
  */
@@ -30,9 +46,15 @@ public:
 
     void init();
     void init(int i);
-
-    void pointToString(const array<double,3>&point);
-    void commandToString(const array<double,4>&command);
+    void buildProfiles();
+    void reserveBuffers();
+    unsigned samplingThreads() const;
+    const SegmentProfile &profile(int i) const;
+    IOData &ioData();
+    void setObserver(SimulationObserver *observer);
+    void setSamplingOptions(const SamplingOptions &options);
+    void setMotionProfile(MotionProfile profile);
+    const AnchorPoints &anchorPoints() const;
 
     void virtual simulate()=0;
     void virtual executeCommand(int i)=0;
@@ -40,6 +62,9 @@ public:
 protected:
     string fileName;
     IOData iodata;
+    std::unique_ptr<SimulationObserver> defaultObserver;
+    SimulationObserver *observer;   //receives the events of the run
+    SamplingOptions sampling;
     double t_a, t_b, t_c, st_a;
     double currentStartTime;
     double nextStartTime;
@@ -48,16 +73,12 @@ protected:
     array<double,3>currentPosition;
     array<double,3>currentStartPoint;
     array<double,3>currentEndPoint;
-    array<double,3>anchoragePoint_R1;
-    array<double,3>anchoragePoint_R2;
-    array<double,3>anchoragePoint_R3;
-    array<double,3>anchoragePoint_R4;
+    AnchorPoints anchors;           //anchorage points of the steel cables
     array<double,3>stagesVector;    //PhasenVector<t_a, t_b, t_c>
 
-    vector<double>timeIntervals;    //t0, ti, ..., tn
-    vector<vector<double>>currentCameraPositions;
-    vector<vector<double>>lengthSteelCables;
+    TrajectoryBuffer trajectory;    //t0..tn, camera positions and cable lengths
     vector<array<double,4>>currentData;
+    vector<SegmentProfile>profiles;    //one per command
 };
 
 #endif // ISIMULATION_H
@@ -3,17 +3,281 @@
 #include <fstream>
 #include <vector>
 #include "simulation.h"
+#include "batch.h"
+#include "streamingsimulation.h"
+#include "profiler.h"
+#include "validation.h"
+#include "retiming.h"
+#include "incrementalsimulation.h"
+#include "trajectoryfile.h"
+#include "playback.h"
+#include <charconv>
+#include <csignal>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
 
 class Simulation;
 
+static void usage(const char *program)
+{
+    std::cout<<" Wrong argument, call the program with "<<program<<" [options] fileName"<<std::endl
+             <<"  --binary     write a binary .traj file instead of _1.out/_2.out"<<std::endl
+             <<"  --float32    store the binary samples as float32"<<std::endl
+             <<"  --precision p  binary samples: float64, float32, fixed (mm), fixed:scale"<<std::endl
+             <<"               or q<bits>; reports the quantization error per segment"<<std::endl
+             <<"  --batch src  simulate every scenario of a directory or list file"<<std::endl
+             <<"  --threads n  number of worker threads of a batch run"<<std::endl
+             <<"  --sample-threads n        threads sampling one long command"<<std::endl
+             <<"  --parallel-threshold n    samples from which a command is split"<<std::endl
+             <<"  --stream name  read the instructions from stdin, write name_1.out/_2.out"<<std::endl
+             <<"  --events s   report of the commands: verbose, buffered, json or none"<<std::endl
+             <<"  --motion m   velocity profile: trapezoid or scurve (needs jmax)"<<std::endl
+             <<"  --blend r    pass tight waypoints on blends of radius r instead of stopping"<<std::endl
+             <<"  --decimate e write only the samples needed to keep the cable lengths within e"<<std::endl
+             <<"  --validate   check the waypoints, cable limits and obstacles, do not simulate"<<std::endl
+             <<"  --retime f   write the instructions with the earliest feasible times to f"<<std::endl
+             <<"  --edit k t x y z  replace instruction k after the run and recompute only"<<std::endl
+             <<"               the commands it changes, can be repeated"<<std::endl
+             <<"  --playback t emit the samples at freq Hz of wall-clock time to t: a file,"<<std::endl
+             <<"               a named pipe, unix:<socket path> or - for stdout"<<std::endl
+             <<"  --profile    print the time spent per stage at exit"<<std::endl
+             <<"  --trace f    with --profile, write a Chrome trace-event file"<<std::endl;
+}
+
+/**
+ * @brief parseNumber reads a whole command-line argument as a number
+ * @return false when text is not a number of type T
+ */
+template <class T>
+static bool parseNumber(const char *text, T &value)
+{
+    const char *last = text + std::strlen(text);
+    std::from_chars_result r = std::from_chars(text, last, value);
+    return r.ec == std::errc() && r.ptr == last && r.ptr != text;
+}
+
+/**
+ * @brief parseEdit reads the k t x y z arguments of --edit
+ */
+static bool parseEdit(char *argv[], std::pair<int, std::array<double,4>> &edit)
+{
+    if (!parseNumber(argv[0], edit.first))
+        return false;
+    for (size_t k = 0; k < edit.second.size(); k++)
+        if (!parseNumber(argv[k + 1], edit.second[k]))
+            return false;
+    return true;
+}
+
+static void quantizationReport(const std::string &fileName)
+{
+    try {
+        reportQuantization(TrajectoryFile(fileName + ".traj"), std::cout);
+    }
+    catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+    }
+}
+
 int main(int argc, char *argv[]) 
 {
-    if (argc<2) {
-        std::cout<<" Wrong argument, call the program with "<<argv[0]<<" fileName"<<std::endl;
+    OutputFormat format = OutputFormat::Text;
+    trajectoryformat::SampleType sampleType = trajectoryformat::SampleType::Float64;
+    double fixedScale = trajectoryformat::defaultFixedScale;
+    std::string fileName;
+    std::string batch;
+    std::string stream;
+    unsigned threads = 0;
+    SamplingOptions sampling;
+    std::string events = "verbose";
+    MotionProfile motion = MotionProfile::Trapezoid;
+    double blend = 0;
+    double decimation = 0;
+    bool validate = false;
+    std::string retimed;
+    std::string playback;
+    std::vector<std::pair<int, std::array<double,4>>> edits;
+    bool profile = false;
+    std::string trace;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (arg == "--binary")
+            format = OutputFormat::Binary;
+        else if (arg == "--float32")
+            sampleType = trajectoryformat::SampleType::Float32;
+        else if (arg == "--precision" && i + 1 < argc && sampleTypeFromName(argv[i+1], sampleType, fixedScale))
+            i++;
+        else if (arg == "--batch" && i + 1 < argc)
+            batch = argv[++i];
+        else if (arg == "--threads" && i + 1 < argc && parseNumber(argv[i+1], threads))
+            i++;
+        else if (arg == "--sample-threads" && i + 1 < argc && parseNumber(argv[i+1], sampling.threads))
+            i++;
+        else if (arg == "--parallel-threshold" && i + 1 < argc &&
+                 parseNumber(argv[i+1], sampling.parallelThreshold))
+            i++;
+        else if (arg == "--stream" && i + 1 < argc)
+            stream = argv[++i];
+        else if (arg == "--events" && i + 1 < argc)
+            events = argv[++i];
+        else if (arg == "--motion" && i + 1 < argc && motionProfileFromName(argv[i+1], motion))
+            i++;
+        else if (arg == "--blend" && i + 1 < argc && parseNumber(argv[i+1], blend))
+            i++;
+        else if (arg == "--decimate" && i + 1 < argc && parseNumber(argv[i+1], decimation))
+            i++;
+        else if (arg == "--retime" && i + 1 < argc)
+            retimed = argv[++i];
+        else if (arg == "--edit" && i + 5 < argc) {
+            std::pair<int, std::array<double,4>> edit;
+            if (!parseEdit(argv + i + 1, edit)) {
+                usage(argv[0]);
+                return 1;
+            }
+            edits.push_back(edit);
+            i += 5;
+        }
+        else if (arg == "--playback" && i + 1 < argc)
+            playback = argv[++i];
+        else if (arg == "--validate")
+            validate = true;
+        else if (arg == "--profile")
+            profile = true;
+        else if (arg == "--trace" && i + 1 < argc)
+            trace = argv[++i];
+        else if (arg.compare(0, 2, "--") == 0 || !fileName.empty()) {
+            usage(argv[0]);
+            return 1;
+        }
+        else
+            fileName = arg;
+    }
+
+    if (blend > 0 && (!stream.empty() || !playback.empty() || !edits.empty() || !retimed.empty())) {
+        //these engines schedule every command from rest to rest
+        std::cerr << "--blend cannot be combined with --stream, --playback, --edit or --retime" << std::endl;
+        return 1;
+    }
+    if (profile)
+        profiler::enable(!trace.empty());
+    const bool quantized = format == OutputFormat::Binary &&
+                           sampleType != trajectoryformat::SampleType::Float64;
+
+    int status = 0;
+    try {
+        if (!batch.empty()) {
+            BatchOptions options;
+            options.threads = threads;
+            options.format = format;
+            options.sampleType = sampleType;
+            options.fixedScale = fixedScale;
+            options.motion = motion;
+            options.blendRadius = blend;
+            options.decimation = decimation;
+            status = runBatch(batch, options, std::cout) == 0 ? 0 : 1;
+        }
+        else if (!stream.empty()) {
+            std::unique_ptr<SimulationObserver> sink = makeSink(events, std::cout);
+            if (!sink) {
+                usage(argv[0]);
+                return 1;
+            }
+            std::ios::sync_with_stdio(false);
+            StreamingSimulation sim(stream);
+            sim.setObserver(sink.get());
+            sim.ioData().setMotionProfile(motion);
+            sim.ioData().setDecimation(decimation);
+            sim.ioData().setOutputFormat(format, sampleType, fixedScale);
+            sim.run(std::cin);
+            if (quantized)
+                quantizationReport(stream);
+        }
+        else if (fileName.empty()) {
+            usage(argv[0]);
+        }
+        else if (validate) {
+            Simulation sim(fileName);
+            vector<Violation> violations = Validator(sim.ioData()).validate();
+            Validator::report(std::cout, violations);
+            status = violations.empty() ? 0 : 1;
+        }
+        else if (!retimed.empty()) {
+            Simulation sim(fileName);
+            sim.setMotionProfile(motion);
+            Retiming retiming = retime(sim.ioData());
+            retiming.report(std::cout);
+            if (!writeRetimedFile(fileName, retimed, retiming)) {
+                std::cerr << "cannot write " << retimed << std::endl;
+                status = 1;
+            }
+        }
+        else if (!playback.empty()) {
+            Simulation sim(fileName);
+            sim.setMotionProfile(motion);
+            TrajectoryIndex index(sim.ioData(), sim.anchorPoints());
+            std::signal(SIGPIPE, SIG_IGN);
+            int fd = openPlaybackTarget(playback);
+            if (fd < 0)
+                return 1;
+            PlaybackStats stats = Playback(index, sim.ioData().getFreq()).run(fd);
+            if (fd != STDOUT_FILENO)
+                ::close(fd);
+            stats.report(std::cerr);
+            status = stats.writeFailed ? 1 : 0;
+        }
+        else if (!edits.empty()) {
+            std::unique_ptr<SimulationObserver> sink = makeSink(events, std::cout);
+            if (!sink) {
+                usage(argv[0]);
+                return 1;
+            }
+            IncrementalSimulation sim(fileName);
+            sim.setObserver(sink.get());
+            sim.ioData().setOutputFormat(format, sampleType, fixedScale);
+            sim.setSamplingOptions(sampling);
+            sim.setMotionProfile(motion);
+            sim.ioData().setDecimation(decimation);
+            sim.simulate();
+            for (const std::pair<int, std::array<double,4>> &edit : edits) {
+                PatchedRange range = sim.setInstruction(edit.first, edit.second);
+                if (range.instruction < 0)
+                    status = 1;
+                range.report(std::cout);
+            }
+            sim.closeOutput();
+            sink->flush();
+            if (quantized)
+                quantizationReport(fileName);
+        }
+        else {
+            std::unique_ptr<SimulationObserver> sink = makeSink(events, std::cout);
+            if (!sink) {
+                usage(argv[0]);
+                return 1;
+            }
+            Simulation sim(fileName);
+            sim.setObserver(sink.get());
+            sim.ioData().setOutputFormat(format, sampleType, fixedScale);
+            sim.setSamplingOptions(sampling);
+            sim.setMotionProfile(motion);
+            sim.setBlendRadius(blend);
+            sim.ioData().setDecimation(decimation);
+            sim.simulate();
+            if (quantized)
+                quantizationReport(fileName);
+        }
     }
-    else {
-        Simulation sim = Simulation(std::string(argv[1]));
-        sim.simulate();
+    catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        status = 1;
+    }
+
+    if (profile) {
+        profiler::report(std::cerr);
+        if (!trace.empty() && !profiler::writeTrace(trace))
+            std::cerr << "cannot write " << trace << std::endl;
     }
-    return 0;
+    return status;
 }
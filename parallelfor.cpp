@@ -0,0 +1,78 @@
+#include "parallelfor.h"
+
+/**
+ * @brief ForkJoinPool::local the pool of the calling thread
+ */
+ForkJoinPool &ForkJoinPool::local()
+{
+    thread_local ForkJoinPool pool;
+    return pool;
+}
+
+ForkJoinPool::~ForkJoinPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    started.notify_all();
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+/**
+ * @brief ForkJoinPool::run calls task for every chunk of [0, count) and
+ *        returns when all of them are done. The calling thread takes the
+ *        first chunk, worker k the chunk k + 1.
+ * @param count : number of items
+ * @param chunk : items per chunk
+ * @param task : called as task(context, first, last)
+ * @param context : passed to task
+ */
+void ForkJoinPool::run(size_t count, size_t chunk, Task task, void *context)
+{
+    const size_t chunks = (count + chunk - 1) / chunk;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (workers.size() < chunks - 1)
+        workers.emplace_back(&ForkJoinPool::work, this, workers.size());
+    this->task = task;
+    this->context = context;
+    this->count = count;
+    this->chunk = chunk;
+    active = chunks - 1;
+    pending = active;
+    job++;
+    lock.unlock();
+    started.notify_all();
+
+    task(context, 0, chunk);
+
+    lock.lock();
+    finished.wait(lock, [this] { return pending == 0; });
+}
+
+/**
+ * @brief ForkJoinPool::work loop of worker index, which handles the chunk
+ *        index + 1 of every job it takes part in
+ */
+void ForkJoinPool::work(size_t index)
+{
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;)
+    {
+        started.wait(lock, [this, seen] { return stopping || job != seen; });
+        if (stopping)
+            return;
+        seen = job;
+        if (index >= active)
+            continue;
+        const size_t first = (index + 1) * chunk;
+        const size_t last = first + chunk < count ? first + chunk : count;
+        lock.unlock();
+        task(context, first, last);
+        lock.lock();
+        if (--pending == 0)
+            finished.notify_one();
+    }
+}
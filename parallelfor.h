@@ -0,0 +1,73 @@
+#ifndef PARALLELFOR_H
+#define PARALLELFOR_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief The ForkJoinPool class keeps the worker threads of parallelFor
+ *        between calls. Each calling thread has its own pool, grown to the
+ *        largest number of threads it asked for; once warm, a call neither
+ *        creates threads nor allocates.
+ */
+class ForkJoinPool
+{
+public:
+    typedef void (*Task)(void *context, size_t first, size_t last);
+
+    static ForkJoinPool &local();
+    ~ForkJoinPool();
+    void run(size_t count, size_t chunk, Task task, void *context);
+
+private:
+    ForkJoinPool() = default;
+    void work(size_t index);
+
+    std::mutex mutex;
+    std::condition_variable started;
+    std::condition_variable finished;
+    std::vector<std::thread> workers;
+    uint64_t job{0};            //incremented by every run()
+    size_t active{0};           //workers taking part in the current job
+    size_t pending{0};          //of them still working
+    bool stopping{false};
+    Task task{nullptr};
+    void *context{nullptr};
+    size_t count{0};
+    size_t chunk{0};
+};
+
+/**
+ * @brief parallelFor splits [0, count) into contiguous chunks, one per
+ *        thread, and calls f(first, last) for each of them. The calling
+ *        thread handles the first chunk, the others run on the pool of the
+ *        calling thread. Chunk borders are multiples of granularity (samples
+ *        per SIMD register) so aligned kernels stay aligned. Every index is
+ *        processed exactly once and by the same code as in the serial case,
+ *        so the results are identical.
+ * @param count : number of items
+ * @param threads : number of threads, 1 runs f(0, count) serially
+ * @param granularity : chunk borders are multiples of it
+ * @param f : callable taking (size_t first, size_t last)
+ */
+template <class F>
+void parallelFor(size_t count, unsigned threads, size_t granularity, F f)
+{
+    size_t chunk = threads > 1 ? (count + threads - 1) / threads : count;
+    chunk = (chunk + granularity - 1) / granularity * granularity;
+    if (threads <= 1 || chunk >= count)
+    {
+        f(static_cast<size_t>(0), count);
+        return;
+    }
+
+    ForkJoinPool::local().run(count, chunk, [](void *context, size_t first, size_t last) {
+        (*static_cast<F *>(context))(first, last);
+    }, &f);
+}
+
+#endif // PARALLELFOR_H
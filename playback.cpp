@@ -0,0 +1,230 @@
+#include "playback.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * @brief formatSample one text line "t x y z L1 .. Ln\n"
+ * @param buffer : large enough for 4 + maxAnchors numbers
+ * @return the length of the line
+ */
+size_t formatSample(const PlaybackSample &sample, char *buffer, size_t size)
+{
+    char *first = buffer;
+    char *last = buffer + size - 1;
+    auto number = [&](double value) {
+        std::to_chars_result r = std::to_chars(first, last, value);
+        first = r.ptr;
+        *first++ = ' ';
+    };
+    number(sample.time);
+    for (double value : sample.position)
+        number(value);
+    for (uint32_t k = 0; k < sample.cableCount; k++)
+        number(sample.cables[k]);
+    first[-1] = '\n';
+    return first - buffer;
+}
+
+/**
+ * @brief writeAll writes the whole line, pipes and sockets may take less
+ * @return false when the target is gone
+ */
+bool writeAll(int fd, bool socket, const char *data, size_t size)
+{
+    while (size > 0)
+    {
+        //send() does not raise SIGPIPE when the peer is gone
+        ssize_t written = socket ? ::send(fd, data, size, MSG_NOSIGNAL) : ::write(fd, data, size);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+}
+
+/**
+ * @brief PlaybackStats::report one line on the timing of the playback
+ */
+void PlaybackStats::report(std::ostream &out) const
+{
+    out << "playback: " << emitted << " samples at " << freq << " Hz, "
+        << misses << " deadline misses, " << underruns << " underruns, lateness mean "
+        << meanLateness * 1e6 << " us, jitter " << jitter * 1e6 << " us, max "
+        << maxLateness * 1e6 << " us" << (writeFailed ? ", the target was closed" : "") << std::endl;
+}
+
+/**
+ * @brief openPlaybackTarget opens the destination of the samples
+ * @param target : "-" for stdout, "unix:<path>" for a UNIX stream socket,
+ *                 otherwise a file or a named pipe
+ * @return a file descriptor, -1 on error
+ */
+int openPlaybackTarget(const string &target)
+{
+    if (target == "-")
+        return STDOUT_FILENO;
+    int fd = -1;
+    if (target.compare(0, 5, "unix:") == 0)
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        const string path = target.substr(5);
+        if (path.size() >= sizeof(address.sun_path))
+        {
+            std::cerr << "socket path too long: " << path << std::endl;
+            return -1;
+        }
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    else
+        fd = ::open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        std::cerr << "cannot open " << target << ": " << std::strerror(errno) << std::endl;
+    return fd;
+}
+
+/**
+ * @brief Playback::Playback
+ * @param index_ : schedule of the run
+ * @param freq_ : samples per second
+ * @param options_ : time span, ring size and spin margin
+ */
+Playback::Playback(const TrajectoryIndex &index_, double freq_, const PlaybackOptions &options_) :
+    index(index_),
+    freq(freq_),
+    options(options_),
+    ring(options_.ringCapacity)
+{
+}
+
+/**
+ * @brief Playback::stop ends run() before the last sample, thread-safe
+ */
+void Playback::stop()
+{
+    stopped.store(true, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Playback::generate producer, evaluates the samples and waits while
+ *        the ring is full
+ * @param first : first sample
+ * @param count : number of samples of the playback
+ */
+void Playback::generate(size_t first, size_t count)
+{
+    const std::chrono::duration<double> period(1 / freq);
+    PlaybackSample sample;
+    for (size_t j = first; j < count && !stopped.load(std::memory_order_relaxed); j++)
+    {
+        sample.time = options.from + j / freq;
+        TrajectorySample state = index.at(sample.time);
+        sample.position = state.position;
+        sample.cables = state.cables;
+        sample.cableCount = static_cast<uint32_t>(state.cableCount);
+        sample.command = state.command;
+        while (!ring.push(sample))
+        {
+            if (stopped.load(std::memory_order_relaxed))
+                return;
+            std::this_thread::sleep_for(period);
+        }
+    }
+}
+
+/**
+ * @brief Playback::run emits the samples on the deadline clock, returns
+ *        after the last one
+ * @param fd : the target, see openPlaybackTarget()
+ * @return the timing of the playback
+ */
+PlaybackStats Playback::run(int fd)
+{
+    PlaybackStats stats;
+    stats.freq = freq;
+    const double to = options.to < 0 ? index.endTime() : options.to;
+    if (freq <= 0 || to < options.from)
+        return stats;
+    const size_t count = static_cast<size_t>(std::floor((to - options.from) * freq)) + 1;
+
+    struct stat info;
+    const bool socket = ::fstat(fd, &info) == 0 && S_ISSOCK(info.st_mode);
+
+    //the ring is filled before the clock starts, the generator keeps it filled
+    stopped.store(false);
+    const size_t prefilled = std::min(count, ring.capacity());
+    generate(0, prefilled);
+    std::thread generator(&Playback::generate, this, prefilled, count);
+
+    const std::chrono::duration<double> spin(options.spinMargin);
+    char line[32 * (4 + maxAnchors)];
+    double sum = 0, sumSquares = 0;
+    PlaybackSample sample;
+    const Clock::time_point start = Clock::now();
+    for (size_t j = 0; j < count && !stopped.load(std::memory_order_relaxed); j++)
+    {
+        const Clock::time_point deadline =
+            start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(j / freq));
+        std::this_thread::sleep_until(deadline - std::chrono::duration_cast<Clock::duration>(spin));
+        while (Clock::now() < deadline)
+            ;
+        bool ready = ring.pop(sample);
+        if (!ready)
+        {
+            stats.underruns++;
+            while (!(ready = ring.pop(sample)) && !stopped.load(std::memory_order_relaxed))
+                std::this_thread::yield();
+            if (!ready)
+                break;
+        }
+        if (!writeAll(fd, socket, line, formatSample(sample, line, sizeof(line))))
+        {
+            stats.writeFailed = true;
+            stop();
+            break;
+        }
+        double lateness = std::chrono::duration<double>(Clock::now() - deadline).count();
+        stats.emitted++;
+        if (lateness > 1 / freq)
+            stats.misses++;
+        stats.maxLateness = std::max(stats.maxLateness, lateness);
+        sum += lateness;
+        sumSquares += lateness * lateness;
+    }
+    generator.join();
+
+    if (stats.emitted > 0)
+    {
+        stats.meanLateness = sum / stats.emitted;
+        stats.jitter = std::sqrt(std::max(0.0, sumSquares / stats.emitted - stats.meanLateness * stats.meanLateness));
+    }
+    return stats;
+}
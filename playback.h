@@ -0,0 +1,88 @@
+#ifndef PLAYBACK_H
+#define PLAYBACK_H
+
+#include "trajectoryindex.h"
+#include "spscring.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+using std::array;
+using std::string;
+
+/**
+ * @brief The PlaybackSample struct, one sample handed to the emitter
+ */
+struct PlaybackSample
+{
+    double time{};
+    array<double,3> position{};
+    array<double,maxAnchors> cables{};
+    uint32_t cableCount{};
+    int32_t command{-1};
+};
+
+/**
+ * @brief The PlaybackOptions struct
+ */
+struct PlaybackOptions
+{
+    double from{0};             //first sample time
+    double to{-1};              //last sample time, < 0: end of the run
+    size_t ringCapacity{4096};  //samples the generator may be ahead
+    double spinMargin{100e-6};  //the emitter sleeps until this much before a deadline, then spins
+};
+
+/**
+ * @brief The PlaybackStats struct, timing of the emitted samples. The
+ *        lateness of a sample is the time between its deadline and the
+ *        return of its write; a miss is a sample later than one period.
+ */
+struct PlaybackStats
+{
+    double freq{};
+    size_t emitted{};
+    size_t misses{};
+    size_t underruns{};         //the generator had not produced the sample at its deadline
+    double meanLateness{};
+    double jitter{};            //standard deviation of the lateness
+    double maxLateness{};
+    bool writeFailed{};
+
+    void report(std::ostream &out) const;
+};
+
+int openPlaybackTarget(const string &target);
+
+/**
+ * @brief The Playback class
+ *
+ * Emits the run at freq samples per second of wall-clock time. A generator
+ * thread evaluates the samples just in time from the segment profiles of a
+ * TrajectoryIndex and pushes them into a bounded SpscRing; the calling
+ * thread pops them and writes one text line per sample,
+ * "t x y z L1 .. Ln", at its deadline. The deadlines are absolute
+ * (start + j / freq), a late sample does not shift the following ones.
+ * The emit loop does not allocate.
+ */
+class Playback
+{
+public:
+    Playback(const TrajectoryIndex &index, double freq,
+             const PlaybackOptions &options = PlaybackOptions());
+    PlaybackStats run(int fd);
+    void stop();
+
+private:
+    void generate(size_t first, size_t count);
+
+    const TrajectoryIndex &index;
+    double freq;
+    PlaybackOptions options;
+    SpscRing<PlaybackSample> ring;
+    std::atomic<bool> stopped{false};
+};
+
+#endif // PLAYBACK_H
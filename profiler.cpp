@@ -0,0 +1,178 @@
+#include "profiler.h"
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sys/resource.h>
+#include <thread>
+#include <vector>
+
+namespace profiler {
+
+namespace {
+
+const char *const stageNames[StageCount] = {
+    "parse", "calculateStagesVector", "calculateTimeIntervals",
+    "currentLine_G", "calculateLengthSteelCables", "output",
+    "validate"
+};
+
+const char *const counterNames[CounterCount] = {
+    "samples generated", "commands succeeded", "commands failed",
+    "commands skipped", "bytes written", "samples written",
+    "buffer growths"
+};
+
+struct TraceEvent
+{
+    Stage stage;
+    int64_t begin;      //ns since enable()
+    int64_t duration;   //ns
+};
+
+/**
+ * @brief The ThreadTrace struct, trace events of one thread. Only the
+ *        owning thread appends, the list is read after the run.
+ */
+struct ThreadTrace
+{
+    int tid;
+    std::vector<TraceEvent> events;
+};
+
+std::atomic<bool> isEnabled{false};
+bool tracing = false;
+std::chrono::steady_clock::time_point origin;
+std::atomic<uint64_t> stageNanoseconds[StageCount];
+std::atomic<uint64_t> stageCalls[StageCount];
+std::atomic<uint64_t> counters[CounterCount];
+std::mutex tracesMutex;
+std::vector<std::unique_ptr<ThreadTrace>> traces;
+
+ThreadTrace &threadTrace()
+{
+    thread_local ThreadTrace *trace = nullptr;
+    if (!trace)
+    {
+        std::lock_guard<std::mutex> lock(tracesMutex);
+        traces.emplace_back(new ThreadTrace{static_cast<int>(traces.size()) + 1, {}});
+        trace = traces.back().get();
+    }
+    return *trace;
+}
+
+}
+
+/**
+ * @brief enable starts the measurement
+ * @param trace : also record every timed scope for writeTrace()
+ */
+void enable(bool trace)
+{
+    origin = std::chrono::steady_clock::now();
+    tracing = trace;
+    isEnabled = true;
+}
+
+bool enabled()
+{
+    return isEnabled.load(std::memory_order_relaxed);
+}
+
+void count(Counter counter, uint64_t n)
+{
+    if (enabled())
+        counters[counter].fetch_add(n, std::memory_order_relaxed);
+}
+
+ScopedTimer::~ScopedTimer()
+{
+    if (!active)
+        return;
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    int64_t duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+    stageNanoseconds[stage].fetch_add(duration, std::memory_order_relaxed);
+    stageCalls[stage].fetch_add(1, std::memory_order_relaxed);
+    if (tracing)
+        threadTrace().events.push_back(
+            {stage, std::chrono::duration_cast<std::chrono::nanoseconds>(begin - origin).count(), duration});
+}
+
+/**
+ * @brief peakMemory reads the peak resident set size of the process. VmHWM
+ * restarts at exec, unlike ru_maxrss which keeps the parent's image
+ * @return the peak RSS in kB
+ */
+long peakMemory()
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+        if (line.compare(0, 6, "VmHWM:") == 0)
+            return std::stol(line.substr(6));
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+/**
+ * @brief report prints the time spent per stage and the counters
+ * @param os : the stream to be written
+ */
+void report(std::ostream &os)
+{
+    if (!enabled())
+        return;
+    double wall = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - origin).count();
+    std::ios::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(3)
+       << "profile (wall time " << wall << " ms)\n"
+       << std::left << std::setw(30) << "stage" << std::right << std::setw(10) << "calls"
+       << std::setw(14) << "total ms" << std::setw(12) << "mean us" << std::setw(9) << "% wall" << '\n';
+    for (int s = 0; s < StageCount; s++)
+    {
+        uint64_t calls = stageCalls[s];
+        double ms = stageNanoseconds[s] / 1e6;
+        os << std::left << std::setw(30) << stageNames[s] << std::right << std::setw(10) << calls
+           << std::setw(14) << ms << std::setw(12) << (calls ? ms * 1000 / calls : 0)
+           << std::setw(8) << (wall > 0 ? 100 * ms / wall : 0) << "%\n";
+    }
+    for (int c = 0; c < CounterCount; c++)
+        os << std::left << std::setw(30) << counterNames[c] << std::right << std::setw(10)
+           << counters[c].load() << '\n';
+    os << std::left << std::setw(30) << "peak RSS kB" << std::right << std::setw(10) << peakMemory() << '\n';
+    os.flags(flags);
+}
+
+/**
+ * @brief writeTrace writes the recorded scopes as Chrome trace-event JSON
+ * @param fileName : the file to be written
+ * @return false if the file could not be written
+ */
+bool writeTrace(const std::string &fileName)
+{
+    std::ofstream out(fileName);
+    if (!out)
+        return false;
+    out << "{\"traceEvents\":[";
+    const char *delim = "\n";
+    std::lock_guard<std::mutex> lock(tracesMutex);
+    for (const std::unique_ptr<ThreadTrace> &trace : traces)
+    {
+        for (const TraceEvent &e : trace->events)
+        {
+            out << delim << "{\"name\":\"" << stageNames[e.stage] << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                << trace->tid << ",\"ts\":" << e.begin / 1000.0 << ",\"dur\":" << e.duration / 1000.0 << "}";
+            delim = ",\n";
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return static_cast<bool>(out);
+}
+
+}
@@ -0,0 +1,79 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/**
+ * Low-overhead instrumentation of the hot paths. The macros below compile
+ * to nothing unless SPIDERCAM_PROFILING is defined (CMake option of the same
+ * name); when compiled in, they cost a flag check until profiler::enable()
+ * is called (spidercam --profile).
+ */
+namespace profiler {
+
+enum Stage
+{
+    Parse,
+    StagesVector,
+    TimeIntervals,
+    LineSampling,
+    CableLengths,
+    Output,
+    Validate,
+    StageCount
+};
+
+enum Counter
+{
+    Samples,
+    CommandsSucceeded,
+    CommandsFailed,
+    CommandsSkipped,
+    BytesWritten,
+    SamplesWritten,
+    BufferGrowths,
+    CounterCount
+};
+
+void enable(bool trace = false);
+bool enabled();
+void count(Counter counter, uint64_t n);
+long peakMemory();
+void report(std::ostream &os);
+bool writeTrace(const std::string &fileName);
+
+/**
+ * @brief The ScopedTimer class adds the lifetime of the object to a stage
+ */
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(Stage stage_) : stage(stage_), active(enabled())
+    {
+        if (active)
+            begin = std::chrono::steady_clock::now();
+    }
+    ~ScopedTimer();
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+    Stage stage;
+    bool active;
+    std::chrono::steady_clock::time_point begin;
+};
+
+}
+
+#ifdef SPIDERCAM_PROFILING
+#define SPIDERCAM_PROFILE_SCOPE(stage) profiler::ScopedTimer spidercamScopedTimer(profiler::stage)
+#define SPIDERCAM_COUNT(counter, n) profiler::count(profiler::counter, (n))
+#else
+#define SPIDERCAM_PROFILE_SCOPE(stage) ((void)0)
+#define SPIDERCAM_COUNT(counter, n) ((void)0)
+#endif
+
+#endif // PROFILER_H
@@ -0,0 +1,145 @@
+#include "quantization.h"
+#include "cpufeatures.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const double fixedLow = -2147483648.0;
+const double fixedHigh = 2147483647.0;
+
+/**
+ * @brief scalarFloat32 reference implementation, also the tail of the
+ *        vectorized kernel
+ */
+double scalarFloat32(const double *values, size_t first, size_t last, double offset, float *out)
+{
+    double error = 0;
+    for (size_t j = first; j < last; j++)
+    {
+        double value = values[j] + offset;
+        out[j] = static_cast<float>(value);
+        error = std::max(error, std::fabs(static_cast<double>(out[j]) - value));
+    }
+    return error;
+}
+
+/**
+ * @brief scalarFixed32 reference implementation, rounds to nearest even like
+ *        the vector conversion
+ */
+double scalarFixed32(const double *values, size_t first, size_t last, double offset, double scale, int32_t *out)
+{
+    double error = 0;
+    for (size_t j = first; j < last; j++)
+    {
+        double value = values[j] + offset;
+        double scaled = std::min(std::max(value * scale, fixedLow), fixedHigh);
+        out[j] = static_cast<int32_t>(std::nearbyint(scaled));
+        error = std::max(error, std::fabs(out[j] / scale - value));
+    }
+    return error;
+}
+
+#ifdef SPIDERCAM_HAVE_AVX2_KERNEL
+__attribute__((target("avx2")))
+double horizontalMax(__m256d v)
+{
+    __m128d m = _mm_max_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    m = _mm_max_sd(m, _mm_unpackhi_pd(m, m));
+    return _mm_cvtsd_f64(m);
+}
+
+/**
+ * @brief avx2Float32 4 samples per iteration, same operations as scalarFloat32
+ */
+__attribute__((target("avx2")))
+double avx2Float32(const double *values, size_t count, double offset, float *out)
+{
+    const size_t n = count & ~static_cast<size_t>(3);
+    const __m256d shift = _mm256_set1_pd(offset);
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    __m256d error = _mm256_setzero_pd();
+    for (size_t j = 0; j < n; j += 4)
+    {
+        __m256d value = _mm256_add_pd(_mm256_loadu_pd(values + j), shift);
+        __m128 narrow = _mm256_cvtpd_ps(value);
+        _mm_storeu_ps(out + j, narrow);
+        __m256d difference = _mm256_sub_pd(_mm256_cvtps_pd(narrow), value);
+        error = _mm256_max_pd(error, _mm256_andnot_pd(sign, difference));
+    }
+    return std::max(horizontalMax(error), scalarFloat32(values, n, count, offset, out));
+}
+
+/**
+ * @brief avx2Fixed32 4 samples per iteration, same operations as scalarFixed32
+ */
+__attribute__((target("avx2")))
+double avx2Fixed32(const double *values, size_t count, double offset, double scale, int32_t *out)
+{
+    const size_t n = count & ~static_cast<size_t>(3);
+    const __m256d shift = _mm256_set1_pd(offset);
+    const __m256d factor = _mm256_set1_pd(scale);
+    const __m256d low = _mm256_set1_pd(fixedLow);
+    const __m256d high = _mm256_set1_pd(fixedHigh);
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    __m256d error = _mm256_setzero_pd();
+    for (size_t j = 0; j < n; j += 4)
+    {
+        __m256d value = _mm256_add_pd(_mm256_loadu_pd(values + j), shift);
+        __m256d scaled = _mm256_min_pd(_mm256_max_pd(_mm256_mul_pd(value, factor), low), high);
+        __m128i fixed = _mm256_cvtpd_epi32(scaled);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + j), fixed);
+        __m256d difference = _mm256_sub_pd(_mm256_div_pd(_mm256_cvtepi32_pd(fixed), factor), value);
+        error = _mm256_max_pd(error, _mm256_andnot_pd(sign, difference));
+    }
+    return std::max(horizontalMax(error), scalarFixed32(values, n, count, offset, scale, out));
+}
+#endif
+
+const bool useAvx2 = cpuHasAvx2();
+
+}
+
+/**
+ * @brief quantizeFloat32 converts a column to float32
+ * @param values : the computed column
+ * @param count : number of samples
+ * @param offset : added to every value before the conversion
+ * @param out : count floats
+ * @return the largest conversion error
+ */
+double quantizeFloat32(const double *values, size_t count, double offset, float *out)
+{
+#ifdef SPIDERCAM_HAVE_AVX2_KERNEL
+    if (useAvx2)
+        return avx2Float32(values, count, offset, out);
+#endif
+    return scalarFloat32(values, 0, count, offset, out);
+}
+
+/**
+ * @brief quantizeFixed32 converts a column to fixed point
+ * @param values : the computed column
+ * @param count : number of samples
+ * @param offset : added to every value before the conversion
+ * @param scale : stored units per unit, 1000 for millimetres
+ * @param out : count integers
+ * @return the largest quantization error, saturation included
+ */
+double quantizeFixed32(const double *values, size_t count, double offset, double scale, int32_t *out)
+{
+#ifdef SPIDERCAM_HAVE_AVX2_KERNEL
+    if (useAvx2)
+        return avx2Fixed32(values, count, offset, scale, out);
+#endif
+    return scalarFixed32(values, 0, count, offset, scale, out);
+}
+
+/**
+ * @brief quantizationKernelName the conversion selected at startup
+ */
+const char *quantizationKernelName()
+{
+    return useAvx2 ? "avx2" : "scalar";
+}
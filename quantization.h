@@ -0,0 +1,18 @@
+#ifndef QUANTIZATION_H
+#define QUANTIZATION_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Conversion of the computed samples to the narrower sample types of the
+ * binary output. Each function writes count values of (values[j] + offset)
+ * and returns the largest absolute difference between a stored value, read
+ * back, and the computed one. Fixed32 stores round((v + offset) * scale),
+ * saturated to the int32 range, and is read back as q / scale.
+ */
+double quantizeFloat32(const double *values, size_t count, double offset, float *out);
+double quantizeFixed32(const double *values, size_t count, double offset, double scale, int32_t *out);
+const char *quantizationKernelName();
+
+#endif // QUANTIZATION_H
@@ -0,0 +1,102 @@
+#include "retiming.h"
+#include "cablekinematics.h"
+#include <algorithm>
+#include <charconv>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+/**
+ * @brief retime computes the earliest feasible schedule
+ * @param iodata : the instructions, the start command at level 0
+ * @return the new start times and the instructions that moved
+ */
+Retiming retime(const IOData &iodata)
+{
+    Retiming result;
+    const int count = iodata.getInstructionsSize();
+    const CableKinematics kinematics(iodata);
+    result.times.resize(count);
+    if (count == 0)
+        return result;
+
+    result.times[0] = iodata.getInstruction(0,0);
+    for (int i = 0; i + 1 < count; i++)
+    {
+        SegmentProfile profile = kinematics.profile(
+            {iodata.getInstruction(i,1), iodata.getInstruction(i,2), iodata.getInstruction(i,3)},
+            {iodata.getInstruction(i+1,1), iodata.getInstruction(i+1,2), iodata.getInstruction(i+1,3)});
+        const double original = iodata.getInstruction(i+1,0);
+        const double end = result.times[i] + profile.t_c;
+        result.times[i+1] = original;
+        if (!(end < original))
+        {
+            result.times[i+1] = std::nextafter(end, HUGE_VAL);
+            result.moved.push_back({i + 1, original, result.times[i+1]});
+        }
+    }
+    result.lastBefore = iodata.getInstruction(count - 1, 0);
+    return result;
+}
+
+/**
+ * @brief Retiming::report the instructions that moved and a summary
+ */
+void Retiming::report(std::ostream &out) const
+{
+    double largest = 0;
+    for (const RetimedInstruction &m : moved)
+    {
+        out << "instruction " << m.instruction << ": " << m.before << "s -> " << m.after
+            << "s (+" << m.after - m.before << "s)" << '\n';
+        largest = std::max(largest, m.after - m.before);
+    }
+    out << "retiming: " << moved.size() << " of " << (times.empty() ? 0 : times.size() - 1)
+        << " instructions moved, largest shift " << largest << "s, last instruction at "
+        << (times.empty() ? 0 : times.back()) << "s (was " << lastBefore << "s)" << std::endl;
+}
+
+/**
+ * @brief writeRetimedFile copies the input file with the new times. Only
+ *        the time of the instruction lines is replaced, directives and
+ *        comments are kept.
+ * @param source : the input file of the simulation
+ * @param destination : the corrected file
+ * @param retiming : times[k] is the time of the k-th instruction line (k >= 1)
+ * @return false if a file cannot be read or written
+ */
+bool writeRetimedFile(const string &source, const string &destination, const Retiming &retiming)
+{
+    std::ifstream in(source);
+    std::ofstream out(destination);
+    if (!in || !out)
+        return false;
+
+    string line;
+    size_t instruction = 1;
+    char number[32];
+    while (std::getline(in, line))
+    {
+        size_t first = 0;
+        while (first < line.size() && (line[first] == ' ' || line[first] == '\t'))
+            first++;
+        if (first < line.size() && std::isdigit(static_cast<unsigned char>(line[first])) &&
+            instruction < retiming.times.size())
+        {
+            size_t last = first;
+            while (last < line.size() && !std::isspace(static_cast<unsigned char>(line[last])))
+                last++;
+            double before = 0;
+            std::from_chars(line.data() + first, line.data() + last, before);
+            if (before != retiming.times[instruction])
+            {
+                std::to_chars_result r = std::to_chars(number, number + sizeof(number), retiming.times[instruction]);
+                line.replace(first, last - first, number, r.ptr - number);
+            }
+            instruction++;
+        }
+        out << line << '\n';
+    }
+    return static_cast<bool>(out);
+}
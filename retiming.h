@@ -0,0 +1,44 @@
+#ifndef RETIMING_H
+#define RETIMING_H
+
+#include "inputData.h"
+#include <ostream>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+/**
+ * @brief The RetimedInstruction struct, an instruction whose time moved
+ */
+struct RetimedInstruction
+{
+    int instruction;        //level in the instruction table, the start command is 0
+    double before;
+    double after;
+};
+
+/**
+ * @brief The Retiming struct
+ *
+ * Earliest feasible schedule of an instruction list: every command runs
+ * from rest to rest and has to end strictly before the next one starts,
+ * the rule Simulation uses. In one pass, each start time is kept if the
+ * previous command ends before it and moved to the first representable
+ * time after the end otherwise, so later commands only shift as far as
+ * needed. With the new times no command fails.
+ */
+struct Retiming
+{
+    vector<double> times;               //new start time of every instruction
+    vector<RetimedInstruction> moved;
+    double lastBefore{};                //time of the last instruction
+
+    void report(std::ostream &out) const;
+};
+
+Retiming retime(const IOData &iodata);
+bool writeRetimedFile(const string &source, const string &destination, const Retiming &retiming);
+
+#endif // RETIMING_H
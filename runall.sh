@@ -1,7 +1,12 @@
 #!/bin/bash
-
-for FILE in `ls Tests/ | grep [^~]$ | grep -v .py$` 
-do
-	echo "Start simulation with file $FILE"
-	./src/build/IHK Tests/$FILE 
-done
+#
+# Regression run over the scenarios of Tests/scenarios.txt: every output is
+# compared with its golden file in Tests/golden, every run with its wall time
+# and peak RSS budget. Exits with 1 when a scenario fails.
+#
+#   ./runall.sh                  uses ./build/spidercam
+#   SPIDERCAM=path ./runall.sh   another build
+#   ./runall.sh --update         records new goldens and budgets
+#
+cd "$(dirname "$0")" || exit 1
+exec python3 Tests/regress.py --binary "${SPIDERCAM:-./build/spidercam}" "$@"
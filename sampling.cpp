@@ -0,0 +1,78 @@
+#include "sampling.h"
+#include "parallelfor.h"
+#include <cmath>
+
+/**
+ * @brief sampleTimeIntervals the discrete times of the command, t_j = j / freq
+ * @param trajectory : resized to the number of samples
+ * @param profile : the command
+ * @param freq : sampling frequency
+ */
+void sampleTimeIntervals(TrajectoryBuffer &trajectory, const SegmentProfile &profile, int freq)
+{
+    sampleTimeIntervals(trajectory, profile.t_c, freq);
+}
+
+/**
+ * @brief sampleTimeIntervals the discrete times of a command of the given duration
+ */
+void sampleTimeIntervals(TrajectoryBuffer &trajectory, double duration, int freq)
+{
+    const int samples = static_cast<int>(std::floor(duration * freq)) + 1;
+    trajectory.resize(samples > 0 ? samples : 0);
+    double *t = trajectory.t();
+    for (int j = 0; j < samples; j++)
+        t[j] = (float)j / freq;
+}
+
+/**
+ * @brief sampleLine the camera's positions on the line at the sampled times
+ */
+void sampleLine(TrajectoryBuffer &trajectory, const SegmentProfile &p, unsigned threads)
+{
+    const double *t = trajectory.t();
+    double *x = trajectory.x();
+    double *y = trajectory.y();
+    double *z = trajectory.z();
+
+    parallelFor(trajectory.size(), threads, 4, [&](size_t first, size_t last) {
+        for (size_t j = first; j < last; j++)
+        {
+            double l = p.lambda(t[j]);
+            x[j] = p.start[0] + l * (p.end[0] - p.start[0]);
+            y[j] = p.start[1] + l * (p.end[1] - p.start[1]);
+            z[j] = p.start[2] + l * (p.end[2] - p.start[2]);
+        }
+    });
+}
+
+/**
+ * @brief sampleBlend the camera's positions on a blended command
+ */
+void sampleBlend(TrajectoryBuffer &trajectory, const BlendedSegment &segment, unsigned threads)
+{
+    const double *t = trajectory.t();
+    double *x = trajectory.x();
+    double *y = trajectory.y();
+    double *z = trajectory.z();
+
+    parallelFor(trajectory.size(), threads, 4, [&](size_t first, size_t last) {
+        for (size_t j = first; j < last; j++)
+        {
+            array<double,3> p = segment.position(t[j]);
+            x[j] = p[0];
+            y[j] = p[1];
+            z[j] = p[2];
+        }
+    });
+}
+
+/**
+ * @brief sampleCableLengths the length of the steel cables at the sampled positions
+ */
+void sampleCableLengths(TrajectoryBuffer &trajectory, const AnchorPoints &anchors, unsigned threads)
+{
+    parallelFor(trajectory.size(), threads, 4, [&](size_t first, size_t last) {
+        calculateCableLengths(trajectory, anchors, first, last);
+    });
+}
@@ -0,0 +1,20 @@
+#ifndef SAMPLING_H
+#define SAMPLING_H
+
+#include "segmentprofile.h"
+#include "trajectorybuffer.h"
+#include "cablekernel.h"
+#include "blendplanner.h"
+
+/**
+ * Sampling of one command into a TrajectoryBuffer, shared by every engine.
+ * The threads argument is the number of threads used for the buffer, the
+ * result does not depend on it.
+ */
+void sampleTimeIntervals(TrajectoryBuffer &trajectory, const SegmentProfile &profile, int freq);
+void sampleTimeIntervals(TrajectoryBuffer &trajectory, double duration, int freq);
+void sampleLine(TrajectoryBuffer &trajectory, const SegmentProfile &profile, unsigned threads);
+void sampleBlend(TrajectoryBuffer &trajectory, const BlendedSegment &segment, unsigned threads);
+void sampleCableLengths(TrajectoryBuffer &trajectory, const AnchorPoints &anchors, unsigned threads);
+
+#endif // SAMPLING_H
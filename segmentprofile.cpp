@@ -0,0 +1,264 @@
+#include "segmentprofile.h"
+#include <cmath>
+
+const int SegmentProfile::maxPhases;
+
+/**
+ * @brief motionProfileFromName parses the name of a profile
+ * @param name : "trapezoid" or "scurve"
+ * @param profile : receives the profile
+ * @return false for an unknown name
+ */
+bool motionProfileFromName(const std::string &name, MotionProfile &profile)
+{
+    if (name == "trapezoid")
+        profile = MotionProfile::Trapezoid;
+    else if (name == "scurve")
+        profile = MotionProfile::SCurve;
+    else
+        return false;
+    return true;
+}
+
+/**
+ * @brief SegmentProfile::SegmentProfile derives the profile of a command
+ * @param start : start point of the command
+ * @param end : end point of the command
+ * @param limits : vmax, amax, jmax and the shape of the profile
+ */
+SegmentProfile::SegmentProfile(const array<double, 3> &start_, const array<double, 3> &end_,
+                               const MotionLimits &limits) :
+    start(start_),
+    end(end_),
+    vmax(limits.vmax),
+    amax(limits.amax),
+    jmax(limits.jmax),
+    shape(limits.profile)
+{
+    double dx = end[0] - start[0];
+    double dy = end[1] - start[1];
+    double dz = end[2] - start[2];
+    delta = std::sqrt(dx * dx + dy * dy + dz * dz);
+    direction = {dx / delta, dy / delta, dz / delta};
+
+    if (shape == MotionProfile::SCurve && jmax > 0)
+        buildSCurve();
+    else
+    {
+        shape = MotionProfile::Trapezoid;
+        buildTrapezoid();
+    }
+}
+
+/**
+ * @brief SegmentProfile::buildTrapezoid accelerate with amax to vmax, cruise,
+ *        decelerate with amax. A move shorter than vmax^2/amax never reaches
+ *        vmax and becomes a triangle with the peak speed sqrt(delta*amax).
+ */
+void SegmentProfile::buildTrapezoid()
+{
+    peakSpeed = vmax;
+    if (delta < vmax * vmax / amax)
+        peakSpeed = std::sqrt(delta * amax);
+
+    double accelerating = peakSpeed / amax;
+    double cruising = peakSpeed < vmax ? 0 : (delta - peakSpeed * accelerating) / vmax;
+
+    const double durations[] = {accelerating, cruising, accelerating};
+    const double jerks[] = {0, 0, 0};
+    const double accelerations[] = {amax, 0, -amax};
+    buildPhases(durations, jerks, accelerations, 3);
+
+    t_a = accelerating;
+    t_b = accelerating + cruising;
+    t_c = t_b + accelerating;
+    s_a = phases[1].s;
+}
+
+/**
+ * @brief SegmentProfile::buildSCurve 7 phases: jerk up, constant acceleration,
+ *        jerk down, cruise and the mirror image for the deceleration.
+ *        Accelerating from rest to v takes v/amax + amax/jmax if amax is
+ *        reached (v >= amax^2/jmax), 2*sqrt(v/jmax) otherwise, and covers
+ *        v/2 times that time. The peak speed of a short move is the root of
+ *        delta = v * time(v), which is closed form in both cases.
+ */
+void SegmentProfile::buildSCurve()
+{
+    const double fullRamp = amax * amax / jmax;     //speed from which amax is reached
+    auto accelerationTime = [&](double v) {
+        return v >= fullRamp ? v / amax + amax / jmax : 2 * std::sqrt(v / jmax);
+    };
+
+    peakSpeed = vmax;
+    if (vmax * accelerationTime(vmax) > delta)
+    {
+        peakSpeed = std::cbrt(delta * delta * jmax / 4);
+        if (peakSpeed >= fullRamp)
+            peakSpeed = (-fullRamp + std::sqrt(fullRamp * fullRamp + 4 * amax * delta)) / 2;
+    }
+
+    double ramp = peakSpeed >= fullRamp ? amax / jmax : std::sqrt(peakSpeed / jmax);
+    double constant = peakSpeed >= fullRamp ? peakSpeed / amax - ramp : 0;
+    double accelerating = 2 * ramp + constant;
+    double cruising = peakSpeed < vmax ? 0 : (delta - peakSpeed * accelerating) / vmax;
+    if (cruising < 0)
+        cruising = 0;
+
+    const double durations[] = {ramp, constant, ramp, cruising, ramp, constant, ramp};
+    const double jerks[] = {jmax, 0, -jmax, 0, -jmax, 0, jmax};
+    const double peak = jmax * ramp;
+    const double accelerations[] = {0, peak, peak, 0, 0, -peak, -peak};
+    buildPhases(durations, jerks, accelerations, 7);
+
+    t_a = accelerating;
+    t_b = accelerating + cruising;
+    t_c = t_b + accelerating;
+    s_a = phases[3].s;
+}
+
+/**
+ * @brief SegmentProfile::buildPhases integrates the phases from rest
+ * @param durations : duration of every phase
+ * @param jerks : jerk of every phase
+ * @param accelerations : acceleration at the begin of every phase
+ * @param count : number of phases
+ */
+void SegmentProfile::buildPhases(const double *durations, const double *jerks,
+                                 const double *accelerations, int count)
+{
+    double begin = 0, s = 0, v = 0;
+    phaseCount = count;
+    for (int k = 0; k < count; k++)
+    {
+        const double d = durations[k];
+        const double j = jerks[k];
+        const double a = accelerations[k];
+        phases[k] = {begin, s, v, a, j};
+        s += d * (v + d * (a / 2 + d * j / 6));
+        v += d * (a + d * j / 2);
+        begin += d;
+    }
+}
+
+/**
+ * @brief SegmentProfile::phase the phase the camera is in at t
+ * @param t: time since the start of the command
+ */
+const SegmentProfile::Phase &SegmentProfile::phase(double t) const
+{
+    int k = 0;
+    while (k + 1 < phaseCount && t >= phases[k + 1].begin)
+        k++;
+    return phases[k];
+}
+
+/**
+ * @brief SegmentProfile::distance calculates the distance traveled
+ * @param t: time since the start of the command
+ * @return the calculated distance, 0 before and delta after the command
+ */
+double SegmentProfile::distance(double t) const
+{
+    if (t <= 0)
+        return 0;
+    if (t >= t_c)
+        return delta;
+    const Phase &p = phase(t);
+    double d = t - p.begin;
+    return p.s + d * (p.v + d * (p.a / 2 + d * p.j / 6));
+}
+
+/**
+ * @brief SegmentProfile::lambda Variable for the camera's line mouvement.
+ * @param t: time since the start of the command
+ * @return the calculated lambda variable
+ */
+double SegmentProfile::lambda(double t) const
+{
+    return delta > 0 ? distance(t) / delta : 0;
+}
+
+/**
+ * @brief SegmentProfile::velocity calculates the actual speed of the camera
+ * @param t : time since the start of the command
+ * @return the speed of the camera.
+ */
+double SegmentProfile::velocity(double t) const
+{
+    return speed(t);
+}
+
+/**
+ * @brief SegmentProfile::speed derivative of distance()
+ * @param t : time since the start of the command
+ * @return the speed of the camera along the line, 0 outside of [0, t_c]
+ */
+double SegmentProfile::speed(double t) const
+{
+    if (t <= 0 || t >= t_c)
+        return 0;
+    const Phase &p = phase(t);
+    double d = t - p.begin;
+    return p.v + d * (p.a + d * p.j / 2);
+}
+
+/**
+ * @brief SegmentProfile::acceleration derivative of speed()
+ * @param t : time since the start of the command
+ * @return the acceleration along the line, 0 outside of [0, t_c]
+ */
+double SegmentProfile::acceleration(double t) const
+{
+    if (t <= 0 || t >= t_c)
+        return 0;
+    const Phase &p = phase(t);
+    return p.a + (t - p.begin) * p.j;
+}
+
+/**
+ * @brief SegmentProfile::stoppingTime time the camera needs to come to rest
+ *        when the command is aborted at t
+ * @param t : time since the start of the command
+ */
+double SegmentProfile::stoppingTime(double t) const
+{
+    double v = speed(t);
+    if (shape == MotionProfile::Trapezoid)
+        return v / amax;
+    const double fullRamp = amax * amax / jmax;
+    return v >= fullRamp ? v / amax + amax / jmax : 2 * std::sqrt(v / jmax);
+}
+
+/**
+ * @brief SegmentProfile::position the camera's position and speed on the line
+ * @param t : time since the start of the command
+ * @param speed : receives ds/dt at t
+ * @return the position of the camera
+ */
+array<double, 3> SegmentProfile::position(double t, double &speed_) const
+{
+    speed_ = speed(t);
+    return position(t);
+}
+
+/**
+ * @brief SegmentProfile::position the camera's position on the line
+ * @param t : time since the start of the command
+ * @return the position of the camera
+ */
+array<double, 3> SegmentProfile::position(double t) const
+{
+    double l = lambda(t);
+    return {start[0] + l * (end[0] - start[0]),
+            start[1] + l * (end[1] - start[1]),
+            start[2] + l * (end[2] - start[2])};
+}
+
+/**
+ * @brief SegmentProfile::stagesVector the 3 stages Ta, Tb and Tc.
+ */
+array<double, 3> SegmentProfile::stagesVector() const
+{
+    return {t_a, t_b, t_c};
+}
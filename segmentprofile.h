@@ -0,0 +1,86 @@
+#ifndef SEGMENTPROFILE_H
+#define SEGMENTPROFILE_H
+
+#include <array>
+#include <string>
+
+using std::array;
+
+/**
+ * Shape of the velocity profile of the commands, selected per run.
+ * Trapezoid: constant acceleration, triangular when the move is too short
+ * to reach vmax. SCurve: 7 phases with the jerk limited to jmax.
+ */
+enum class MotionProfile { Trapezoid, SCurve };
+
+bool motionProfileFromName(const std::string &name, MotionProfile &profile);
+
+/**
+ * @brief The MotionLimits struct, the limits a profile is built from.
+ *        jmax <= 0 means unlimited jerk, an SCurve then is a trapezoid.
+ */
+struct MotionLimits
+{
+    double vmax{};
+    double amax{};
+    double jmax{};
+    MotionProfile profile{MotionProfile::Trapezoid};
+};
+
+/**
+ * @brief The SegmentProfile class
+ *
+ * Immutable motion profile of one command (start point -> end point).
+ * Everything that only depends on the geometry of the command and on the
+ * limits is derived once into a table of phases with constant jerk, so
+ * sampling is a pure function of (profile, t): find the phase, evaluate
+ * one cubic.
+ */
+class SegmentProfile
+{
+public:
+    static const int maxPhases = 7;
+
+    /**
+     * @brief The Phase struct, state at the begin of a phase of constant jerk
+     */
+    struct Phase
+    {
+        double begin;               //time since the start of the command
+        double s, v, a, j;
+    };
+
+    SegmentProfile() = default;
+    SegmentProfile(const array<double,3> &start, const array<double,3> &end,
+                   const MotionLimits &limits);
+
+    double distance(double t) const;     //s(t)
+    double lambda(double t) const;
+    double velocity(double t) const;
+    double speed(double t) const;        //ds/dt
+    double acceleration(double t) const; //d2s/dt2
+    double stoppingTime(double t) const;
+    array<double,3> position(double t) const;
+    array<double,3> position(double t, double &speed) const;
+    array<double,3> stagesVector() const;
+    const Phase &phase(double t) const;
+
+    array<double,3> start{};
+    array<double,3> end{};
+    array<double,3> direction{};    //unit vector from start to end
+    double delta{};
+    double t_a{}, t_b{}, t_c{}, s_a{};  //end of acceleration, begin of deceleration, end
+    double vmax{}, amax{}, jmax{};
+    double peakSpeed{};             //below vmax for short moves
+    MotionProfile shape{MotionProfile::Trapezoid};
+    int phaseCount{0};
+    array<Phase, maxPhases> phases{};
+
+private:
+    void buildTrapezoid();
+    void buildSCurve();
+    void buildPhases(const double *durations, const double *jerks,
+                     const double *accelerations, int count);
+};
+
+#endif // SEGMENTPROFILE_H
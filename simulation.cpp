@@ -1,4 +1,6 @@
 #include "simulation.h"
+#include "profiler.h"
+#include "sampling.h"
 // ios::exceptions
 #include <stdexcept> //std::out_of_range
 #include <iostream>
@@ -10,88 +12,185 @@
  * @brief Simulation::Simulation constructs the simulation class
  * @param fileName : the input file for the simulation
  */
-Simulation::Simulation(const string &fileName_) : ISimulation(fileName_)
+Simulation::Simulation(const string &fileName_) : ISimulation(fileName_),
+    cursor(0)
 {
-
+    for (int i = 0; i < iodata.getInstructionsSize(); i++)
+        initialStartTimes.push_back(iodata.getInstruction(i,0));
 }
 
 /**
- * @brief Simulation::simulate starts the simulation's process
+ * @brief Simulation::simulate runs the simulation's process from the first
+ *        command to the end. It can be called several times.
  */
 void Simulation::simulate()
 {
-    static int i = 0;
-    executeCommand(i);
+    reset();
+    while (step())
+        ;
+    iodata.closeOutput();
+    observer->flush();
+}
+
+/**
+ * @brief Simulation::reset restores the start times changed by rescheduling
+ *        and moves back to the first command
+ */
+void Simulation::reset()
+{
+    for (size_t i = 0; i < initialStartTimes.size(); i++)
+        iodata.setInstruction(i,0) = initialStartTimes[i];
+    cursor = 0;
+    stats = SimulationStats();
+    chain = BlendChain();
+    iodata.closeOutput();
+}
+
+/**
+ * @brief Simulation::getStats counters of the current run
+ */
+const SimulationStats &Simulation::getStats() const
+{
+    return stats;
+}
+
+/**
+ * @brief Simulation::setBlendRadius lets tight commands pass their waypoints
+ *        on a blend instead of stopping
+ * @param radius : largest distance between a waypoint and its blend, 0 disables blending
+ */
+void Simulation::setBlendRadius(double radius)
+{
+    planner = BlendPlanner(radius);
+}
+
+/**
+ * @brief Simulation::commandBufferGrowths times the last executed command
+ *        grew the trajectory or output buffer, 0 once they are large enough.
+ *        Other heap allocations are not counted, spidercam_bench counts them
+ *        with its own operator new.
+ */
+size_t Simulation::commandBufferGrowths() const
+{
+    return lastBufferGrowths;
+}
+
+/**
+ * @brief Simulation::finished
+ * @return true when no command is left to execute
+ */
+bool Simulation::finished() const
+{
+    return cursor < 0 || cursor >= iodata.getInstructionsSize() - 1;
+}
+
+/**
+ * @brief Simulation::step executes the next scheduled command
+ * @return true while commands are left to execute
+ */
+bool Simulation::step()
+{
+    if (finished())
+        return false;
+    executeCommand(cursor);
+    return !finished();
 }
 
 /**
- * @brief Simulation::executeCommand : recursive method for the execution logic
- *                                     of the simulation
+ * @brief Simulation::executeCommand : executes one command and schedules
+ *                                     the next one
  * @param i : command level
  */
 void Simulation::executeCommand(int i)
 {
-    if ((size_t)i >= iodata.getInstructionsSize()-1)
+    cursor = -1;
+    lastBufferGrowths = 0;
+    if (i < 0 || i >= iodata.getInstructionsSize()-1)
         return;
+    const size_t growths = trajectory.allocations() + iodata.outputBufferGrowths();
     try
     {
         init(i);
-        currentStartTime = iodata.getInstruction(i,0);
+        CommandDecision decision;
+        if (!chain.contains(i))
+        {
+            decision = decideCommand(iodata, profile(i), i);
+            if (!decision.succeeded)
+                chain = planner.plan(iodata, i);
+        }
+        const BlendedSegment *blend = chain.contains(i) ? &chain.segment(i) : nullptr;
+        if (blend)
+            decision = blend->decision;
+        applyDecision(iodata, decision);
+
+        currentStartTime = decision.startTime;
         calculateStagesVector(i);
+        if (blend)
+        {
+            stagesVector = blend->stages;
+            t_c = blend->duration;
+        }
         currentExecutionTime = t_c;
-        nextStartTime = iodata.getInstruction(i+1,0);
-        if (nextStartTime == 0 || (currentStartTime + currentExecutionTime < nextStartTime))
+        nextStartTime = decision.nextStartTime;
+        CommandEvent event;
+        event.command = i;
+        event.from = iodata.getInstruction(i);
+        event.from[0] = decision.startTime;
+        event.to = iodata.getInstruction(i + 1);
+        event.executionTime = t_c;
+        event.stagesVector = stagesVector;
+        if (decision.succeeded)
         {
-            std::cout << "command " << i <<" succeeds" << std::endl;
-            std::cout << "from: " << std::endl;
-            commandToString(iodata.getInstruction(i));
-            std::cout << "to : " << std::endl;
-            commandToString(iodata.getInstruction(i + 1));
-            std::cout << "execution time: " << t_c << " seconds" << std::endl;
-            calculateStagesVector(i);
-            std::cout << "StageVector: "<<std::endl;
-            pointToString(stagesVector);
-            std::cout<<std::endl;
+            observer->commandSucceeded(event);
 
-            calculateCurrentDelta(i);
-            calculateTimeIntervals(i);
-            currentLine_G(i);
+            if (blend)
+                sampleBlend(*blend);
+            else
+            {
+                calculateTimeIntervals(i);
+                currentLine_G(i);
+            }
             calculateLengthSteelCables(i);
 
-            iodata.output(lengthSteelCables);
-            iodata.output(timeIntervals,currentCameraPositions);
-            i++;
-            executeCommand(i);
+            iodata.output(trajectory, currentStartTime, i);
+            stats.succeeded++;
+            stats.samples += trajectory.size();
+            SPIDERCAM_COUNT(CommandsSucceeded, 1);
+            SPIDERCAM_COUNT(Samples, trajectory.size());
         }
         else
         {
-            std::cout << "command " << i <<" failed!" << std::endl;
-            std::cout << "from: " << std::endl;
-            commandToString(iodata.getInstruction(i));
-            std::cout << "to : " << std::endl;
-            commandToString(iodata.getInstruction(i + 1));
-            std::cout << "command needs " << t_c << " seconds for the execution" << std::endl;
-            double cameraStopTime = currentStartTime + (nextStartTime - currentStartTime) +
-                                     currentVelocity(i, nextStartTime - currentStartTime) / iodata.getAmax();
-            std::cout << "camera stopped at " << cameraStopTime<<"s";
-            //calculateCurrentCameraPosition(i,cameraStopTime);
-            //pointToString(currentPosition);
-            std::cout<<std::endl;
-            calculateStagesVector(i);
-            std::cout << "StageVector: "<<std::endl;
-            pointToString(stagesVector);
-            std::cout<<std::endl;
-
-            if ((size_t)i + 2 < iodata.getInstructionsSize() - 1 && cameraStopTime > iodata.getInstruction(i+2,0))
+            observer->commandFailed(event);
+            observer->cameraStopped(event, decision.cameraStopTime);
+            stats.failed++;
+            SPIDERCAM_COUNT(CommandsFailed, 1);
+            if (decision.rescheduled)
             {
-                iodata.setInstruction(i+2,0) = cameraStopTime;
-                i += 2;
-                executeCommand(i);
+                observer->commandRescheduled(i + 2, decision.cameraStopTime);
+                stats.skipped++;
+                SPIDERCAM_COUNT(CommandsSkipped, 1);
             }
         }
+        cursor = decision.next;
+        lastBufferGrowths = trajectory.allocations() + iodata.outputBufferGrowths() - growths;
+        stats.bufferGrowths += lastBufferGrowths;
+        SPIDERCAM_COUNT(BufferGrowths, lastBufferGrowths);
     }
     catch (const std::out_of_range &oor)
     {
         std::cerr << "Out of Range error: " << oor.what() << std::endl;
     }
 }
+
+/**
+ * @brief Simulation::sampleBlend samples a command of a blend chain
+ */
+void Simulation::sampleBlend(const BlendedSegment &segment)
+{
+    {
+        SPIDERCAM_PROFILE_SCOPE(TimeIntervals);
+        sampleTimeIntervals(trajectory, segment.duration, iodata.getFreq());
+    }
+    SPIDERCAM_PROFILE_SCOPE(LineSampling);
+    ::sampleBlend(trajectory, segment, samplingThreads());
+}
@@ -2,6 +2,8 @@
 #define SIMULATION_H
 
 #include "isimulation.h"
+#include "commandscheduler.h"
+#include "blendplanner.h"
 #include <string>
 #include <vector>
 #include <array>
@@ -10,6 +12,18 @@ using std::string;
 using std::array;
 using std::vector;
 
+/**
+ * @brief The SimulationStats struct, counters of one run
+ */
+struct SimulationStats
+{
+    int succeeded{};
+    int failed{};
+    int skipped{};      //commands jumped over by rescheduling
+    size_t samples{};
+    size_t bufferGrowths{}; //times the sample buffers grew, not heap allocations
+};
+
 class Simulation : public ISimulation
 {
 
@@ -18,6 +32,22 @@ public:
     ~Simulation(){};
     void simulate() override;
     void executeCommand(int i) override;
+    bool step();
+    void reset();
+    bool finished() const;
+    const SimulationStats &getStats() const;
+    void setBlendRadius(double radius);
+    size_t commandBufferGrowths() const;
+
+private:
+    void sampleBlend(const BlendedSegment &segment);
+
+    int cursor;                         //next command level, -1 when finished
+    vector<double> initialStartTimes;   //restored by reset()
+    SimulationStats stats;
+    BlendPlanner planner{0};            //radius 0: every command stops at its waypoint
+    BlendChain chain;                   //chain of the current command, if any
+    size_t lastBufferGrowths{0};        //times the last command grew a sample buffer
 };
 
 #endif // SIMULATION_H
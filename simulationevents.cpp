@@ -0,0 +1,246 @@
+#include "simulationevents.h"
+#include <charconv>
+#include <sstream>
+
+namespace {
+
+const size_t blockSize = 1 << 16;
+
+}
+
+/**
+ * @brief TextSink::TextSink
+ * @param out : the stream receiving the report
+ * @param buffered_ : false flushes every line like std::endl
+ */
+TextSink::TextSink(std::ostream &out, bool buffered_) :
+    target(out),
+    buffered(buffered_)
+{
+}
+
+TextSink::~TextSink()
+{
+    flush();
+}
+
+std::ostream &TextSink::line()
+{
+    return buffered ? static_cast<std::ostream &>(block) : target;
+}
+
+void TextSink::endLine()
+{
+    if (!buffered)
+    {
+        target << std::endl;
+        return;
+    }
+    block << '\n';
+    if (static_cast<size_t>(block.tellp()) >= blockSize)
+        flush();
+}
+
+/**
+ * @brief TextSink::command prints a command: "ts at [x,y,z]"
+ */
+void TextSink::command(const array<double, 4> &command)
+{
+    line() << command[0] << "s"
+           << " at "
+           << "[" << command[1] << ","
+           << command[2] << ","
+           << command[3] << "]";
+    endLine();
+}
+
+/**
+ * @brief TextSink::point prints a point: "[x,y,z]"
+ */
+void TextSink::point(const array<double, 3> &point)
+{
+    line() << "[" << point[0] << ","
+           << point[1] << ","
+           << point[2] << "]";
+    endLine();
+}
+
+void TextSink::commandSucceeded(const CommandEvent &event)
+{
+    line() << "command " << event.command << " succeeds";
+    endLine();
+    line() << "from: ";
+    endLine();
+    command(event.from);
+    line() << "to : ";
+    endLine();
+    command(event.to);
+    line() << "execution time: " << event.executionTime << " seconds";
+    endLine();
+    line() << "StageVector: ";
+    endLine();
+    point(event.stagesVector);
+    endLine();
+}
+
+void TextSink::commandFailed(const CommandEvent &event)
+{
+    line() << "command " << event.command << " failed!";
+    endLine();
+    line() << "from: ";
+    endLine();
+    command(event.from);
+    line() << "to : ";
+    endLine();
+    command(event.to);
+    line() << "command needs " << event.executionTime << " seconds for the execution";
+    endLine();
+}
+
+void TextSink::cameraStopped(const CommandEvent &event, double time)
+{
+    line() << "camera stopped at " << time << "s";
+    endLine();
+    line() << "StageVector: ";
+    endLine();
+    point(event.stagesVector);
+    endLine();
+}
+
+void TextSink::commandRescheduled(int command, double startTime)
+{
+    line() << "command " << command << " rescheduled to " << startTime << "s";
+    endLine();
+    endLine();
+}
+
+void TextSink::flush()
+{
+    if (buffered && block.tellp() > 0)
+    {
+        target << block.str();
+        target.flush();
+        block.str(string());
+    }
+}
+
+JsonLinesSink::JsonLinesSink(std::ostream &out) :
+    target(out)
+{
+    text.reserve(blockSize);
+}
+
+JsonLinesSink::~JsonLinesSink()
+{
+    flush();
+}
+
+void JsonLinesSink::begin(const char *event, int command)
+{
+    text += "{\"event\":\"";
+    text += event;
+    text += "\",\"command\":";
+    text += std::to_string(command);
+}
+
+/**
+ * @brief JsonLinesSink::number shortest representation that reads back exactly
+ */
+void JsonLinesSink::number(double value)
+{
+    char digits[32];
+    std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+    text.append(digits, result.ptr);
+}
+
+template <size_t N>
+void JsonLinesSink::numbers(const array<double, N> &values)
+{
+    text += '[';
+    for (size_t k = 0; k < N; k++)
+    {
+        if (k > 0)
+            text += ',';
+        number(values[k]);
+    }
+    text += ']';
+}
+
+void JsonLinesSink::end()
+{
+    text += "}\n";
+    if (text.size() >= blockSize)
+        flush();
+}
+
+void JsonLinesSink::commandSucceeded(const CommandEvent &event)
+{
+    begin("succeeded", event.command);
+    text += ",\"from\":";
+    numbers(event.from);
+    text += ",\"to\":";
+    numbers(event.to);
+    text += ",\"execution_time\":";
+    number(event.executionTime);
+    text += ",\"stages\":";
+    numbers(event.stagesVector);
+    end();
+}
+
+void JsonLinesSink::commandFailed(const CommandEvent &event)
+{
+    begin("failed", event.command);
+    text += ",\"from\":";
+    numbers(event.from);
+    text += ",\"to\":";
+    numbers(event.to);
+    text += ",\"execution_time\":";
+    number(event.executionTime);
+    text += ",\"stages\":";
+    numbers(event.stagesVector);
+    end();
+}
+
+void JsonLinesSink::cameraStopped(const CommandEvent &event, double time)
+{
+    begin("camera_stopped", event.command);
+    text += ",\"time\":";
+    number(time);
+    end();
+}
+
+void JsonLinesSink::commandRescheduled(int command, double startTime)
+{
+    begin("rescheduled", command);
+    text += ",\"start_time\":";
+    number(startTime);
+    end();
+}
+
+void JsonLinesSink::flush()
+{
+    if (text.empty())
+        return;
+    target.write(text.data(), static_cast<std::streamsize>(text.size()));
+    target.flush();
+    text.clear();
+}
+
+/**
+ * @brief makeSink creates a sink from its command line name
+ * @param name : verbose, buffered, json or none
+ * @param out : the stream receiving the events
+ * @return the sink, nullptr for an unknown name
+ */
+std::unique_ptr<SimulationObserver> makeSink(const string &name, std::ostream &out)
+{
+    if (name == "verbose")
+        return std::unique_ptr<SimulationObserver>(new VerboseTextSink(out));
+    if (name == "buffered")
+        return std::unique_ptr<SimulationObserver>(new BufferedTextSink(out));
+    if (name == "json")
+        return std::unique_ptr<SimulationObserver>(new JsonLinesSink(out));
+    if (name == "none")
+        return std::unique_ptr<SimulationObserver>(new NullSink);
+    return nullptr;
+}
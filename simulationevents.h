@@ -0,0 +1,114 @@
+#ifndef SIMULATIONEVENTS_H
+#define SIMULATIONEVENTS_H
+
+#include <array>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+using std::array;
+using std::string;
+
+/**
+ * @brief The CommandEvent struct, what is reported about one command
+ */
+struct CommandEvent
+{
+    int command{};
+    array<double,4> from{};             //t, x, y, z
+    array<double,4> to{};
+    double executionTime{};
+    array<double,3> stagesVector{};     //t_a, t_b, t_c
+};
+
+/**
+ * @brief The SimulationObserver class
+ *
+ * Receives the events of a run. The engine does not write to the console
+ * itself, the sinks below decide what is reported and how.
+ */
+class SimulationObserver
+{
+public:
+    virtual ~SimulationObserver() {}
+    virtual void commandSucceeded(const CommandEvent &) {}
+    virtual void commandFailed(const CommandEvent &) {}
+    virtual void cameraStopped(const CommandEvent &, double) {}
+    virtual void commandRescheduled(int, double) {}
+    virtual void flush() {}
+};
+
+/**
+ * @brief The NullSink class ignores every event
+ */
+class NullSink : public SimulationObserver
+{
+};
+
+/**
+ * @brief The TextSink class, the human readable report of the commands.
+ *        Unbuffered, every line is flushed; buffered, the report is handed
+ *        over to the stream in blocks and by flush().
+ */
+class TextSink : public SimulationObserver
+{
+public:
+    TextSink(std::ostream &out, bool buffered);
+    ~TextSink() override;
+    void commandSucceeded(const CommandEvent &event) override;
+    void commandFailed(const CommandEvent &event) override;
+    void cameraStopped(const CommandEvent &event, double time) override;
+    void commandRescheduled(int command, double startTime) override;
+    void flush() override;
+
+private:
+    std::ostream &line();
+    void endLine();
+    void command(const array<double,4> &command);
+    void point(const array<double,3> &point);
+
+    std::ostream &target;
+    bool buffered;
+    std::ostringstream block;
+};
+
+class VerboseTextSink : public TextSink
+{
+public:
+    explicit VerboseTextSink(std::ostream &out) : TextSink(out, false) {}
+};
+
+class BufferedTextSink : public TextSink
+{
+public:
+    explicit BufferedTextSink(std::ostream &out) : TextSink(out, true) {}
+};
+
+/**
+ * @brief The JsonLinesSink class, one JSON object per event and line
+ */
+class JsonLinesSink : public SimulationObserver
+{
+public:
+    explicit JsonLinesSink(std::ostream &out);
+    ~JsonLinesSink() override;
+    void commandSucceeded(const CommandEvent &event) override;
+    void commandFailed(const CommandEvent &event) override;
+    void cameraStopped(const CommandEvent &event, double time) override;
+    void commandRescheduled(int command, double startTime) override;
+    void flush() override;
+
+private:
+    void begin(const char *event, int command);
+    void number(double value);
+    template <size_t N> void numbers(const array<double,N> &values);
+    void end();
+
+    std::ostream &target;
+    string text;
+};
+
+std::unique_ptr<SimulationObserver> makeSink(const string &name, std::ostream &out);
+
+#endif // SIMULATIONEVENTS_H
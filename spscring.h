@@ -0,0 +1,82 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+/**
+ * @brief The SpscRing class
+ *
+ * Bounded lock-free queue between exactly one producer thread and one
+ * consumer thread. The slots are allocated once by the constructor, push()
+ * and pop() never allocate nor block. Each side keeps a cached copy of the
+ * other side's index and only reloads it when the ring looks full (or
+ * empty), so the indices rarely move between the cores.
+ */
+template <class T>
+class SpscRing
+{
+public:
+    /**
+     * @param capacity : rounded up to a power of two
+     */
+    explicit SpscRing(size_t capacity)
+    {
+        size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        slots.reset(new T[size]);
+        mask = size - 1;
+    }
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    size_t capacity() const { return mask + 1; }
+
+    /**
+     * @brief push producer side
+     * @return false when the ring is full
+     */
+    bool push(const T &value)
+    {
+        const size_t position = tail.load(std::memory_order_relaxed);
+        if (position - cachedHead > mask)
+        {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (position - cachedHead > mask)
+                return false;
+        }
+        slots[position & mask] = value;
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief pop consumer side
+     * @return false when the ring is empty
+     */
+    bool pop(T &value)
+    {
+        const size_t position = head.load(std::memory_order_relaxed);
+        if (position == cachedTail)
+        {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (position == cachedTail)
+                return false;
+        }
+        value = slots[position & mask];
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::unique_ptr<T[]> slots;
+    size_t mask{0};
+    alignas(64) std::atomic<size_t> head{0};    //next slot to be read, written by the consumer
+    size_t cachedTail{0};                       //consumer's copy of tail
+    alignas(64) std::atomic<size_t> tail{0};    //next slot to be written, written by the producer
+    size_t cachedHead{0};                       //producer's copy of head
+};
+
+#endif // SPSCRING_H
@@ -0,0 +1,122 @@
+#include "streamingsimulation.h"
+#include "commandscheduler.h"
+#include "sampling.h"
+#include "profiler.h"
+#include <iostream>
+
+/**
+ * @brief StreamingSimulation::StreamingSimulation
+ * @param outputName : base name of the output files
+ */
+StreamingSimulation::StreamingSimulation(const string &outputName) :
+    defaultObserver(new VerboseTextSink(std::cout)),
+    observer(defaultObserver.get())
+{
+    iodata.setFileName(outputName);
+}
+
+/**
+ * @brief StreamingSimulation::setObserver selects the receiver of the events
+ * @param observer_ : not owned, nullptr restores the verbose console report
+ */
+void StreamingSimulation::setObserver(SimulationObserver *observer_)
+{
+    observer = observer_ ? observer_ : defaultObserver.get();
+}
+
+/**
+ * @brief StreamingSimulation::run reads the input line by line until its end
+ * @param in : the input, e.g. std::cin
+ */
+void StreamingSimulation::run(std::istream &in)
+{
+    string line;
+    array<double,4> instruction;
+    while (std::getline(in, line))
+    {
+        if (iodata.parseLine(line.data(), line.data() + line.size(), instruction))
+            push(instruction);
+    }
+    process(true);
+    iodata.closeOutput();
+    observer->flush();
+}
+
+/**
+ * @brief StreamingSimulation::push adds an instruction to the window; the
+ *        first one is preceded by the start command
+ */
+void StreamingSimulation::push(const array<double, 4> &instruction)
+{
+    if (stopped)
+        return;
+    if (!started)
+    {
+        started = true;
+        anchors = iodata.getAnchors();
+        kinematics.reset(new CableKinematics(iodata));
+        trajectory.resize(0, anchors.size());
+        window.push_back({0, iodata.getStart()[0], iodata.getStart()[1], iodata.getStart()[2]});
+    }
+    window.push_back(instruction);
+    process(false);
+}
+
+/**
+ * @brief StreamingSimulation::process decides every command the window
+ *        allows, with the same rule as Simulation::executeCommand
+ * @param endOfInput : no instruction follows the window
+ */
+void StreamingSimulation::process(bool endOfInput)
+{
+    while (!stopped && window.size() >= (endOfInput ? 2u : 4u))
+    {
+        const array<double,4> &from = window[0];
+        const array<double,4> &to = window[1];
+        SegmentProfile profile = kinematics->profile({from[1], from[2], from[3]}, {to[1], to[2], to[3]});
+        const double *afterNext = window.size() >= 4 ? &window[2][0] : nullptr;
+        CommandDecision decision = decideCommand(profile, command, from[0], to[0],
+                                                 afterNext);
+
+        CommandEvent event;
+        event.command = command;
+        event.from = from;
+        event.to = to;
+        event.executionTime = profile.t_c;
+        event.stagesVector = profile.stagesVector();
+        if (decision.succeeded)
+        {
+            observer->commandSucceeded(event);
+            sampleTimeIntervals(trajectory, profile, iodata.getFreq());
+            sampleLine(trajectory, profile, 1);
+            sampleCableLengths(trajectory, anchors, 1);
+            iodata.output(trajectory, decision.startTime, command);
+            iodata.flushOutput();
+            stats.succeeded++;
+            stats.samples += trajectory.size();
+            SPIDERCAM_COUNT(CommandsSucceeded, 1);
+            SPIDERCAM_COUNT(Samples, trajectory.size());
+            window.pop_front();
+            command++;
+            continue;
+        }
+
+        observer->commandFailed(event);
+        observer->cameraStopped(event, decision.cameraStopTime);
+        stats.failed++;
+        SPIDERCAM_COUNT(CommandsFailed, 1);
+        if (!decision.rescheduled)
+        {
+            stopped = true;
+            window.clear();
+            break;
+        }
+        observer->commandRescheduled(command + 2, decision.cameraStopTime);
+        stats.skipped++;
+        SPIDERCAM_COUNT(CommandsSkipped, 1);
+        window[2][0] = decision.cameraStopTime;
+        window.pop_front();
+        window.pop_front();
+        command += 2;
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef STREAMINGSIMULATION_H
+#define STREAMINGSIMULATION_H
+
+#include "inputData.h"
+#include "simulationevents.h"
+#include "simulation.h"
+#include "cablekernel.h"
+#include "cablekinematics.h"
+#include <deque>
+#include <istream>
+#include <string>
+
+using std::string;
+
+/**
+ * @brief The StreamingSimulation class
+ *
+ * Simulates an input of unbounded length, e.g. waypoints piped in by a
+ * choreography generator. The directives (dim, start, vmax, amax, freq)
+ * have to come before the first instruction. Instructions are kept in a
+ * window of at most 4 entries: the current command, the next two (needed
+ * by the rescheduling) and one more, which tells whether command i+2 is
+ * the last one. Every command is sampled and written as soon as it is
+ * decided, memory use does not depend on the length of the input.
+ */
+class StreamingSimulation
+{
+public:
+    explicit StreamingSimulation(const string &outputName);
+
+    void setObserver(SimulationObserver *observer);
+    IOData &ioData() { return iodata; }
+    void run(std::istream &in);
+    const SimulationStats &getStats() const { return stats; }
+
+private:
+    void push(const array<double,4> &instruction);
+    void process(bool endOfInput);
+
+    IOData iodata;
+    std::unique_ptr<SimulationObserver> defaultObserver;
+    SimulationObserver *observer;
+    std::deque<array<double,4>> window;
+    int command{0};             //command level of window.front()
+    bool started{false};
+    bool stopped{false};
+    AnchorPoints anchors{};
+    std::unique_ptr<CableKinematics> kinematics;    //created with the first instruction
+    TrajectoryBuffer trajectory;
+    SimulationStats stats;
+};
+
+#endif // STREAMINGSIMULATION_H
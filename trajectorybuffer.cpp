@@ -0,0 +1,59 @@
+#include "trajectorybuffer.h"
+#include <cstdint>
+#include <utility>
+
+const size_t TrajectoryBuffer::alignment;
+
+/**
+ * @brief TrajectoryBuffer::resize sets the number of samples and cables of
+ *        the buffer. The content is not preserved when the buffer has to grow.
+ * @param samples_ : number of samples of the current command
+ * @param cables_ : number of steel cables of the rig
+ */
+void TrajectoryBuffer::resize(size_t samples_, size_t cables_)
+{
+    if (samples_ > stride || 4 + cables_ > columns)
+    {
+        const size_t perRegister = alignment / sizeof(double);
+        size_t newStride = samples_ > stride ? (samples_ + perRegister - 1) / perRegister * perRegister
+                                             : stride;
+        size_t newColumns = 4 + cables_ > columns ? 4 + cables_ : columns;
+        storage.reset(new double[newStride * newColumns + perRegister]);
+        uintptr_t address = reinterpret_cast<uintptr_t>(storage.get());
+        address = (address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+        base = reinterpret_cast<double *>(address);
+        stride = newStride;
+        columns = newColumns;
+        allocated++;
+    }
+    samples = samples_;
+    cables = cables_;
+}
+
+/**
+ * @brief TrajectoryBuffer::reserve allocates the storage for a number of
+ *        samples and cables up front, without changing the size
+ */
+void TrajectoryBuffer::reserve(size_t samples_, size_t cables_)
+{
+    const size_t size = samples;
+    const size_t count = cables;
+    resize(samples_, cables_);
+    samples = size;
+    cables = count;
+}
+
+/**
+ * @brief TrajectoryBuffer::swap exchanges the storage of two buffers, the
+ *        column pointer has to move along with the block
+ */
+void TrajectoryBuffer::swap(TrajectoryBuffer &other) noexcept
+{
+    storage.swap(other.storage);
+    std::swap(base, other.base);
+    std::swap(samples, other.samples);
+    std::swap(cables, other.cables);
+    std::swap(stride, other.stride);
+    std::swap(columns, other.columns);
+    std::swap(allocated, other.allocated);
+}
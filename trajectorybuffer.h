@@ -0,0 +1,58 @@
+#ifndef TRAJECTORYBUFFER_H
+#define TRAJECTORYBUFFER_H
+
+#include <cstddef>
+#include <memory>
+
+/**
+ * @brief The TrajectoryBuffer class
+ *
+ * Structure-of-arrays storage for the sampled trajectory of one command:
+ * time, x, y, z and the length of every steel cable. All columns live in
+ * one 32-byte aligned block that is reused across commands; it only grows
+ * when a command needs more samples (or cables) than any command before.
+ * reserve() sizes it up front, allocations() counts the blocks allocated.
+ */
+class TrajectoryBuffer
+{
+public:
+    static const size_t alignment = 32;     //bytes, one AVX register
+
+    TrajectoryBuffer() = default;
+    TrajectoryBuffer(TrajectoryBuffer &&other) noexcept { swap(other); }
+    TrajectoryBuffer &operator=(TrajectoryBuffer &&other) noexcept { swap(other); return *this; }
+    void swap(TrajectoryBuffer &other) noexcept;
+
+    void resize(size_t samples, size_t cables);
+    void resize(size_t samples) { resize(samples, cables); }
+    void reserve(size_t samples, size_t cables);
+    size_t allocations() const { return allocated; }
+    size_t size() const { return samples; }
+    size_t cableCount() const { return cables; }
+    size_t capacity() const { return stride; }
+
+    double *t() { return column(0); }
+    double *x() { return column(1); }
+    double *y() { return column(2); }
+    double *z() { return column(3); }
+    double *cable(size_t k) { return column(4 + k); }
+    const double *t() const { return column(0); }
+    const double *x() const { return column(1); }
+    const double *y() const { return column(2); }
+    const double *z() const { return column(3); }
+    const double *cable(size_t k) const { return column(4 + k); }
+
+private:
+    double *column(size_t c) { return base + c * stride; }
+    const double *column(size_t c) const { return base + c * stride; }
+
+    std::unique_ptr<double[]> storage;
+    double *base{nullptr};
+    size_t samples{0};
+    size_t cables{4};
+    size_t stride{0};       //capacity of one column, multiple of 4 doubles
+    size_t columns{0};      //columns the storage was allocated for
+    size_t allocated{0};    //number of blocks allocated so far
+};
+
+#endif // TRAJECTORYBUFFER_H
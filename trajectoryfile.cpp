@@ -0,0 +1,147 @@
+#include "trajectoryfile.h"
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <ostream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace trajectoryformat;
+
+/**
+ * @brief TrajectoryFile::TrajectoryFile maps a binary trajectory file and
+ *        checks its header and segment table
+ * @param fileName : the .traj file to be read
+ */
+TrajectoryFile::TrajectoryFile(const string &fileName)
+{
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("cannot open " + fileName);
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < offsetof(TrajectoryFileHeader, scale))
+    {
+        ::close(fd);
+        throw std::runtime_error(fileName + " is not a trajectory file");
+    }
+    mappingSize = static_cast<size_t>(info.st_size);
+    void *address = ::mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED)
+        throw std::runtime_error("cannot map " + fileName);
+    mapping = static_cast<const char *>(address);
+    head = reinterpret_cast<const TrajectoryFileHeader *>(mapping);
+
+    string error;
+    if (std::memcmp(head->magic, magic, sizeof(magic)) != 0)
+        error = " is not a trajectory file";
+    else if (head->version < 1 || head->version > version)
+        error = " has an unsupported version";
+    else if (head->version >= 2 && mappingSize < sizeof(TrajectoryFileHeader))
+        error = " is truncated";
+    else if (head->segmentTableOffset == 0)
+        error = " was not closed properly";
+    else if (head->segmentTableOffset + head->segmentCount * sizeof(TrajectorySegmentEntry) > mappingSize)
+        error = " is truncated";
+    if (!error.empty())
+    {
+        ::munmap(const_cast<char *>(mapping), mappingSize);
+        throw std::runtime_error(fileName + error);
+    }
+    table = reinterpret_cast<const TrajectorySegmentEntry *>(mapping + head->segmentTableOffset);
+}
+
+TrajectoryFile::~TrajectoryFile()
+{
+    if (mapping)
+        ::munmap(const_cast<char *>(mapping), mappingSize);
+}
+
+SampleType TrajectoryFile::sampleType() const
+{
+    return static_cast<SampleType>(head->sampleType);
+}
+
+/**
+ * @brief TrajectoryFile::scale stored units per unit of a Fixed32 file
+ * @return 0 for the files without a scale (version 1)
+ */
+double TrajectoryFile::scale() const
+{
+    return head->version >= 2 ? head->scale : 0;
+}
+
+/**
+ * @brief TrajectoryFile::relativeTimes whether the time columns hold the
+ *        time since the startTime of their segment instead of global times
+ */
+bool TrajectoryFile::relativeTimes() const
+{
+    return sampleType() == SampleType::Fixed32 ||
+           (sampleType() == SampleType::Float32 && head->version >= 3);
+}
+
+size_t TrajectoryFile::segmentCount() const
+{
+    return static_cast<size_t>(head->segmentCount);
+}
+
+size_t TrajectoryFile::cableCount() const
+{
+    return head->cableCount;
+}
+
+const TrajectorySegmentEntry &TrajectoryFile::segment(size_t i) const
+{
+    if (i >= segmentCount())
+        throw std::out_of_range("trajectory segment out of range");
+    return table[i];
+}
+
+/**
+ * @brief TrajectoryFile::columnData start of a column of a segment
+ * @param s : segment
+ * @param c : column, 0 = t, 1..3 = x/y/z, 4.. = cables
+ * @param size : size of the requested sample type, must match the file
+ */
+const void *TrajectoryFile::columnData(size_t s, size_t c, uint32_t size) const
+{
+    if (size != trajectoryformat::sampleSize(sampleType()))
+        throw std::invalid_argument("sample type does not match the trajectory file");
+    if (c >= head->columnCount)
+        throw std::out_of_range("trajectory column out of range");
+    const TrajectorySegmentEntry &entry = segment(s);
+    uint64_t offset = entry.offset + c * columnBytes(sampleType(), entry.samples);
+    if (offset + entry.samples * size > mappingSize)
+        throw std::out_of_range("trajectory segment is truncated");
+    return mapping + offset;
+}
+
+/**
+ * @brief reportQuantization the largest quantization error of every segment
+ *        and of the whole file
+ * @param file : a trajectory file
+ * @param out : one line per segment and a summary
+ */
+void reportQuantization(const TrajectoryFile &file, std::ostream &out)
+{
+    static const char *names[] = {"float64", "float32", "fixed32"};
+    const uint32_t type = static_cast<uint32_t>(file.sampleType());
+    double largest = 0;
+    for (size_t s = 0; s < file.segmentCount(); s++)
+    {
+        const TrajectorySegmentEntry &entry = file.segment(s);
+        double error = file.header().version >= 2 ? entry.quantizationError : 0;
+        largest = std::max(largest, error);
+        out << "segment " << s << " command " << entry.command << ": " << entry.samples
+            << " samples, max quantization error " << error << std::endl;
+    }
+    out << "quantization: " << (type < 3 ? names[type] : "unknown");
+    if (file.sampleType() == SampleType::Fixed32)
+        out << " scale " << file.scale();
+    out << ", " << sampleSize(file.sampleType()) << " bytes per value, "
+        << file.segmentCount() << " segments, max error " << largest << std::endl;
+}
@@ -0,0 +1,81 @@
+#ifndef TRAJECTORYFILE_H
+#define TRAJECTORYFILE_H
+
+#include "trajectoryformat.h"
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+
+using std::string;
+
+/**
+ * @brief The Span class, a read-only view on a column of the file
+ */
+template <class T>
+class Span
+{
+public:
+    Span() = default;
+    Span(const T *data_, size_t size_) : first(data_), count(size_) {}
+
+    const T *data() const { return first; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const T &operator[](size_t i) const { return first[i]; }
+    const T *begin() const { return first; }
+    const T *end() const { return first + count; }
+
+private:
+    const T *first{nullptr};
+    size_t count{0};
+};
+
+/**
+ * @brief The TrajectoryFile class
+ *
+ * Memory-mapped reader of a binary trajectory file. The spans returned
+ * point into the mapping and stay valid as long as the object lives.
+ * Fixed32 columns are read as int32_t, see trajectoryformat.h.
+ */
+class TrajectoryFile
+{
+public:
+    explicit TrajectoryFile(const string &fileName);
+    ~TrajectoryFile();
+    TrajectoryFile(const TrajectoryFile &) = delete;
+    TrajectoryFile &operator=(const TrajectoryFile &) = delete;
+
+    const trajectoryformat::TrajectoryFileHeader &header() const { return *head; }
+    trajectoryformat::SampleType sampleType() const;
+    double scale() const;
+    bool relativeTimes() const;
+    size_t segmentCount() const;
+    size_t cableCount() const;
+    const trajectoryformat::TrajectorySegmentEntry &segment(size_t i) const;
+
+    template <class T> Span<T> column(size_t segment, size_t column) const;
+    template <class T> Span<T> time(size_t s) const { return column<T>(s, 0); }
+    template <class T> Span<T> x(size_t s) const { return column<T>(s, 1); }
+    template <class T> Span<T> y(size_t s) const { return column<T>(s, 2); }
+    template <class T> Span<T> z(size_t s) const { return column<T>(s, 3); }
+    template <class T> Span<T> cable(size_t s, size_t k) const { return column<T>(s, 4 + k); }
+
+private:
+    const void *columnData(size_t segment, size_t column, uint32_t sampleSize) const;
+
+    const char *mapping{nullptr};
+    size_t mappingSize{0};
+    const trajectoryformat::TrajectoryFileHeader *head{nullptr};
+    const trajectoryformat::TrajectorySegmentEntry *table{nullptr};
+};
+
+template <class T>
+Span<T> TrajectoryFile::column(size_t s, size_t c) const
+{
+    return Span<T>(static_cast<const T *>(columnData(s, c, sizeof(T))),
+                   static_cast<size_t>(segment(s).samples));
+}
+
+void reportQuantization(const TrajectoryFile &file, std::ostream &out);
+
+#endif // TRAJECTORYFILE_H
@@ -0,0 +1,77 @@
+#ifndef TRAJECTORYFORMAT_H
+#define TRAJECTORYFORMAT_H
+
+#include <cstdint>
+
+/**
+ * Binary trajectory file (.traj), native little-endian layout:
+ *
+ *   TrajectoryFileHeader
+ *   per command: column-major blocks t, x, y, z, L1..Ln
+ *                (samples values of sampleType each, 8-byte aligned)
+ *   TrajectorySegmentEntry[segmentCount]   at segmentTableOffset
+ *
+ * The header is rewritten when the file is closed, a file with
+ * segmentTableOffset == 0 was not closed properly.
+ *
+ * Fixed32 samples are int32 values q = round(v * scale), read back as
+ * q / scale. The float64 time columns hold global times. The float32 and
+ * fixed32 time columns hold the time since the startTime of the segment,
+ * so that long runs neither lose resolution nor overflow; float32 times
+ * are global in files before version 3. Version 1 files have no scale and
+ * no quantization error, both read as 0.
+ */
+namespace trajectoryformat {
+
+const char magic[8] = {'S', 'P', 'C', 'T', 'R', 'A', 'J', '\0'};
+const uint32_t version = 3;
+const double defaultFixedScale = 1000;     //millimetres
+
+enum class SampleType : uint32_t
+{
+    Float64 = 0,
+    Float32 = 1,
+    Fixed32 = 2
+};
+
+struct TrajectoryFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t sampleType;
+    double dim[3];
+    double freq;
+    double vmax;
+    double amax;
+    uint32_t cableCount;
+    uint32_t columnCount;       //4 + cableCount
+    uint64_t segmentCount;
+    uint64_t segmentTableOffset;
+    double scale;               //Fixed32: stored units per unit, version 2
+};
+
+struct TrajectorySegmentEntry
+{
+    uint64_t offset;            //first column, from the start of the file
+    uint64_t samples;
+    double startTime;
+    int32_t command;
+    float quantizationError;    //largest error of x, y, z and the cables, 0 for float64
+};
+
+inline uint32_t sampleSize(SampleType type)
+{
+    return type == SampleType::Float64 ? 8 : 4;
+}
+
+/**
+ * @brief columnBytes size of one column, padded to 8 bytes
+ */
+inline uint64_t columnBytes(SampleType type, uint64_t samples)
+{
+    return (samples * sampleSize(type) + 7) & ~static_cast<uint64_t>(7);
+}
+
+}
+
+#endif // TRAJECTORYFORMAT_H
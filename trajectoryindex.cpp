@@ -0,0 +1,102 @@
+#include "trajectoryindex.h"
+#include "commandscheduler.h"
+#include "cablekinematics.h"
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief TrajectoryIndex::TrajectoryIndex schedules the instruction list
+ * @param iodata : the instructions, the start command at level 0
+ * @param anchors_ : the anchorage points of the steel cables
+ */
+TrajectoryIndex::TrajectoryIndex(const IOData &iodata, const AnchorPoints &anchors_) :
+    anchors(anchors_)
+{
+    const int count = iodata.getInstructionsSize();
+    const CableKinematics kinematics(iodata);
+    vector<double> times(count);
+    for (int i = 0; i < count; i++)
+        times[i] = iodata.getInstruction(i,0);
+    if (count > 0)
+        restPosition = {iodata.getInstruction(0,1), iodata.getInstruction(0,2), iodata.getInstruction(0,3)};
+
+    int i = 0;
+    while (i >= 0 && i < count - 1)
+    {
+        SegmentProfile profile = kinematics.profile(
+            {iodata.getInstruction(i,1), iodata.getInstruction(i,2), iodata.getInstruction(i,3)},
+            {iodata.getInstruction(i+1,1), iodata.getInstruction(i+1,2), iodata.getInstruction(i+1,3)});
+        bool hasAfterNext = i + 2 < count - 1;
+        CommandDecision decision = decideCommand(profile, i, times[i], times[i+1],
+                                                 hasAfterNext ? &times[i+2] : nullptr);
+        if (decision.succeeded)
+        {
+            segments.push_back({decision.startTime, i, profile});
+            startTimes.push_back(decision.startTime);
+        }
+        if (decision.rescheduled)
+            times[i+2] = decision.cameraStopTime;
+        i = decision.next;
+    }
+}
+
+/**
+ * @brief TrajectoryIndex::endTime end of the last executed command
+ */
+double TrajectoryIndex::endTime() const
+{
+    if (segments.empty())
+        return 0;
+    return segments.back().startTime + segments.back().profile.t_c;
+}
+
+/**
+ * @brief TrajectoryIndex::cableLengths lengths of the steel cables at the
+ *        position of the sample
+ */
+void TrajectoryIndex::cableLengths(TrajectorySample &sample) const
+{
+    sample.cableCount = anchors.size();
+    for (size_t k = 0; k < anchors.size(); k++)
+    {
+        double dx = sample.position[0] - anchors[k][0];
+        double dy = sample.position[1] - anchors[k][1];
+        double dz = sample.position[2] - anchors[k][2];
+        sample.cables[k] = std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+}
+
+/**
+ * @brief TrajectoryIndex::at state of the camera at a global time
+ * @param t : global time
+ * @return position, velocity and cable lengths at t
+ */
+TrajectorySample TrajectoryIndex::at(double t) const
+{
+    TrajectorySample sample;
+    std::vector<double>::const_iterator it = std::upper_bound(startTimes.begin(), startTimes.end(), t);
+    if (it == startTimes.begin())
+    {
+        sample.position = restPosition;
+    }
+    else
+    {
+        const Segment &segment = segments[it - startTimes.begin() - 1];
+        const SegmentProfile &p = segment.profile;
+        double local = t - segment.startTime;
+        if (local <= p.t_c)
+        {
+            double speed;
+            sample.position = p.position(local, speed);
+            //a hold on the same waypoint has no direction (NaN), it does not move
+            if (p.t_c > 0 && p.delta > 0)
+                for (size_t k = 0; k < sample.velocity.size(); k++)
+                    sample.velocity[k] = speed * p.direction[k];
+            sample.command = segment.command;
+        }
+        else
+            sample.position = p.end;
+    }
+    cableLengths(sample);
+    return sample;
+}
@@ -0,0 +1,60 @@
+#ifndef TRAJECTORYINDEX_H
+#define TRAJECTORYINDEX_H
+
+#include "inputData.h"
+#include "segmentprofile.h"
+#include "cablekernel.h"
+#include <array>
+#include <vector>
+
+using std::array;
+using std::vector;
+
+/**
+ * @brief The TrajectorySample struct, state of the camera at a global time
+ */
+struct TrajectorySample
+{
+    array<double,3> position{};
+    array<double,3> velocity{};
+    array<double,maxAnchors> cables{};
+    size_t cableCount{0};   //valid entries of cables
+    int command{-1};        //command being executed, -1 while the camera waits
+};
+
+/**
+ * @brief The TrajectoryIndex class
+ *
+ * Schedule of a whole run, built once from the instruction list with the
+ * same succeed/fail/reschedule rule as Simulation. Querying a global time
+ * is a binary search over the start times of the executed commands followed
+ * by the closed-form evaluation of one profile, no sampling is involved.
+ * Between two executed commands the camera waits at the last end point.
+ */
+class TrajectoryIndex
+{
+public:
+    TrajectoryIndex(const IOData &iodata, const AnchorPoints &anchors);
+
+    TrajectorySample at(double t) const;
+    size_t segmentCount() const { return segments.size(); }
+    double startTime(size_t segment) const { return segments[segment].startTime; }
+    double endTime() const;
+
+private:
+    struct Segment
+    {
+        double startTime;
+        int command;
+        SegmentProfile profile;
+    };
+
+    void cableLengths(TrajectorySample &sample) const;
+
+    vector<Segment> segments;
+    vector<double> startTimes;      //copy of the segment start times for the search
+    array<double,3> restPosition{};
+    AnchorPoints anchors;
+};
+
+#endif // TRAJECTORYINDEX_H
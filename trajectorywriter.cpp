@@ -0,0 +1,516 @@
+#include "trajectorywriter.h"
+#include "profiler.h"
+#include "quantization.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+const size_t BufferedFile::blockSize;
+const size_t BinaryTrajectoryWriter::tableChunk;
+
+/**
+ * @brief BufferedFile::BufferedFile opens (and truncates) the output file
+ * @param fileName : the file to be written
+ */
+BufferedFile::BufferedFile(const string &fileName) :
+    name(fileName),
+    file(fileName, std::ios::binary | std::ios::trunc),
+    block(blockSize)
+{
+    file.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+}
+
+BufferedFile::~BufferedFile()
+{
+    try
+    {
+        close();
+    }
+    catch (std::ofstream::failure &e)
+    {
+        std::cerr << e.what() << std::endl;
+    }
+}
+
+/**
+ * @brief BufferedFile::reserve makes room for size bytes in the block
+ */
+void BufferedFile::reserve(size_t size)
+{
+    if (used + size > block.size())
+        flush();
+}
+
+void BufferedFile::write(const char *data, size_t size)
+{
+    if (size >= block.size())
+    {
+        flush();
+        file.write(data, size);
+        written += size;
+        SPIDERCAM_COUNT(BytesWritten, size);
+        return;
+    }
+    reserve(size);
+    std::memcpy(block.data() + used, data, size);
+    used += size;
+}
+
+void BufferedFile::put(char c)
+{
+    reserve(1);
+    block[used++] = c;
+}
+
+/**
+ * @brief BufferedFile::number writes a number with 6 significant digits like
+ *        std::showpoint, the decimal point and the trailing zeros are kept
+ * @param value : the number to be written
+ */
+void BufferedFile::number(double value)
+{
+    const int precision = 6;
+    char digits[32];
+    std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value,
+                                                std::chars_format::general, precision);
+    char *end = result.ptr;
+    char *exponent = std::find(digits, end, 'e');
+    reserve(40);
+    char *out = block.data() + used;
+
+    //mantissa, counting its significant digits
+    int significant = 0;
+    bool point = false;
+    bool finite = std::isfinite(value);
+    for (char *c = digits; c != exponent; c++)
+    {
+        if (*c == '.')
+            point = true;
+        else if (*c >= '0' && *c <= '9' && (significant > 0 || *c != '0'))
+            significant++;
+        *out++ = *c;
+    }
+    if (finite)
+    {
+        if (significant == 0)   //the value 0 has one significant digit
+            significant = 1;
+        if (!point)
+            *out++ = '.';
+        for (; significant < precision; significant++)
+            *out++ = '0';
+    }
+    out = std::copy(exponent, end, out);
+    used = out - block.data();
+}
+
+/**
+ * @brief BufferedFile::patch overwrites bytes that were already written
+ * @param offset : position in the file
+ */
+void BufferedFile::patch(size_t offset, const void *data, size_t size)
+{
+    flush();
+    file.seekp(offset);
+    file.write(static_cast<const char *>(data), size);
+    file.seekp(0, std::ios::end);
+}
+
+/**
+ * @brief BufferedFile::truncate drops everything from offset on, the next
+ *        writes continue there
+ * @param offset : new size of the file
+ */
+void BufferedFile::truncate(size_t offset)
+{
+    if (offset >= bytesWritten())
+        return;
+    flush();
+    std::error_code error;
+    std::filesystem::resize_file(name, offset, error);
+    if (error)
+        throw std::ofstream::failure("cannot truncate " + name + ": " + error.message());
+    file.seekp(offset);
+    written = offset;
+}
+
+/**
+ * @brief BufferedFile::flush hands the block over to the file
+ */
+void BufferedFile::flush()
+{
+    if (used == 0 || !file.is_open())
+        return;
+    file.write(block.data(), used);
+    file.flush();
+    written += used;
+    SPIDERCAM_COUNT(BytesWritten, used);
+    used = 0;
+}
+
+void BufferedFile::close()
+{
+    if (!file.is_open())
+        return;
+    flush();
+    file.close();
+}
+
+/**
+ * @brief TextTrajectoryWriter::TextTrajectoryWriter opens the 2 output files
+ *        of the simulation and writes the arena
+ * @param fileName : the input file of the simulation
+ * @param dim : dimension of the arena
+ */
+TextTrajectoryWriter::TextTrajectoryWriter(const string &fileName, const array<double, 3> &dim) :
+    cables(fileName + "_1.out"),
+    positions(fileName + "_2.out")
+{
+    writeRow(positions, dim.data(), dim.size());
+}
+
+/**
+ * @brief TextTrajectoryWriter::writeRow writes one column of the trajectory as a line
+ * @param out : the output file
+ * @param data : the values to be written
+ * @param size : the number of values
+ * @param offset : added to every value
+ */
+void TextTrajectoryWriter::writeRow(BufferedFile &out, const double *data, size_t size, double offset)
+{
+    for (size_t j = 0; j < size; j++)
+    {
+        if (j > 0)
+            out.write(", ", 2);
+        out.number(data[j] + offset);
+    }
+    out.put('\n');
+}
+
+/**
+ * @brief TextTrajectoryWriter::writeSegment appends a sampled command
+ * @param trajectory : the sampled command
+ * @param startTime : start time of the command, makes the times global
+ */
+void TextTrajectoryWriter::writeSegment(const TrajectoryBuffer &trajectory, double startTime, int)
+{
+    if (patchable)
+        starts.push_back({cables.bytesWritten(), positions.bytesWritten()});
+    for (size_t k = 0; k < trajectory.cableCount(); k++)
+        writeRow(cables, trajectory.cable(k), trajectory.size());
+
+    writeRow(positions, trajectory.t(), trajectory.size(), startTime);
+    writeRow(positions, trajectory.x(), trajectory.size());
+    writeRow(positions, trajectory.y(), trajectory.size());
+    writeRow(positions, trajectory.z(), trajectory.size());
+}
+
+/**
+ * @brief TextTrajectoryWriter::reserve sizes the table of segment offsets
+ */
+void TextTrajectoryWriter::reserve(size_t, size_t commands)
+{
+    if (patchable)
+        starts.reserve(commands);
+}
+
+/**
+ * @brief TextTrajectoryWriter::enablePatching records where every segment
+ *        starts from now on; a run that is not edited does not keep them
+ */
+void TextTrajectoryWriter::enablePatching()
+{
+    patchable = true;
+}
+
+/**
+ * @brief TextTrajectoryWriter::replaceSegments the lines of the segments are
+ *        sequential, so both files are cut before segment first
+ * @return false, the caller writes every segment from first on again
+ */
+bool TextTrajectoryWriter::replaceSegments(size_t first, size_t)
+{
+    if (!patchable)
+        throw std::runtime_error("the output " + cables.fileName() + " was not opened for patching");
+    if (first < starts.size())
+    {
+        cables.truncate(starts[first][0]);
+        positions.truncate(starts[first][1]);
+        starts.resize(first);
+    }
+    return false;
+}
+
+void TextTrajectoryWriter::flush()
+{
+    cables.flush();
+    positions.flush();
+}
+
+void TextTrajectoryWriter::close()
+{
+    cables.close();
+    positions.close();
+}
+
+/**
+ * @brief sampleTypeFromName parses the precision of the binary samples
+ * @param name : "float64", "float32", "fixed" (millimetres), "fixed:<scale>"
+ *               or "q<bits>" for a scale of 2^bits
+ * @param type : receives the sample type
+ * @param scale : receives the scale of the fixed-point types
+ * @return false for an unknown name or an invalid scale
+ */
+bool sampleTypeFromName(const string &name, trajectoryformat::SampleType &type, double &scale)
+{
+    scale = trajectoryformat::defaultFixedScale;
+    if (name == "float64")
+        type = trajectoryformat::SampleType::Float64;
+    else if (name == "float32")
+        type = trajectoryformat::SampleType::Float32;
+    else if (name == "fixed")
+        type = trajectoryformat::SampleType::Fixed32;
+    else if (name.compare(0, 6, "fixed:") == 0 || (name.size() > 1 && name[0] == 'q'))
+    {
+        const bool bits = name[0] == 'q';
+        const char *first = name.data() + (bits ? 1 : 6);
+        const char *last = name.data() + name.size();
+        double value = 0;
+        std::from_chars_result r = std::from_chars(first, last, value);
+        if (r.ec != std::errc() || r.ptr != last || value <= 0 || (bits && (value > 30 || value != std::floor(value))))
+            return false;
+        type = trajectoryformat::SampleType::Fixed32;
+        scale = bits ? std::ldexp(1.0, static_cast<int>(value)) : value;
+    }
+    else
+        return false;
+    return true;
+}
+
+/**
+ * @brief BinaryTrajectoryWriter::BinaryTrajectoryWriter opens fileName.traj
+ *        and writes a provisional header
+ * @param fileName : the input file of the simulation
+ * @param dim : dimension of the arena
+ * @param freq, vmax, amax : parameters of the simulation
+ * @param sampleType : float64, float32 or fixed32 samples
+ * @param cableCount : number of cables of the rig, every segment has as many
+ * @param scale : stored units per unit of the fixed32 samples
+ */
+BinaryTrajectoryWriter::BinaryTrajectoryWriter(const string &fileName, const array<double, 3> &dim,
+                                               int freq, int vmax, int amax,
+                                               trajectoryformat::SampleType sampleType,
+                                               size_t cableCount, double scale) :
+    file(fileName + ".traj"),
+    header()
+{
+    std::memcpy(header.magic, trajectoryformat::magic, sizeof(header.magic));
+    header.version = trajectoryformat::version;
+    header.sampleType = static_cast<uint32_t>(sampleType);
+    for (size_t k = 0; k < dim.size(); k++)
+        header.dim[k] = dim[k];
+    header.freq = freq;
+    header.vmax = vmax;
+    header.amax = amax;
+    header.cableCount = cableCount;
+    header.columnCount = 4 + cableCount;
+    header.scale = sampleType == trajectoryformat::SampleType::Fixed32 ? scale : 0;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+/**
+ * @brief BinaryTrajectoryWriter::writeColumn writes one column, converted to
+ *        the sample type of the file and padded to 8 bytes
+ * @param offset : added to every value
+ * @return the largest conversion error of the column
+ */
+double BinaryTrajectoryWriter::writeColumn(const double *data, size_t size, double offset)
+{
+    const trajectoryformat::SampleType type = static_cast<trajectoryformat::SampleType>(header.sampleType);
+    double error = 0;
+    if (type == trajectoryformat::SampleType::Float32)
+    {
+        scratch32.resize(size);
+        error = quantizeFloat32(data, size, offset, scratch32.data());
+        file.write(reinterpret_cast<const char *>(scratch32.data()), size * sizeof(float));
+    }
+    else if (type == trajectoryformat::SampleType::Fixed32)
+    {
+        scratchFixed.resize(size);
+        error = quantizeFixed32(data, size, offset, header.scale, scratchFixed.data());
+        file.write(reinterpret_cast<const char *>(scratchFixed.data()), size * sizeof(int32_t));
+    }
+    else if (offset != 0)
+    {
+        scratch64.resize(size);
+        for (size_t j = 0; j < size; j++)
+            scratch64[j] = data[j] + offset;
+        file.write(reinterpret_cast<const char *>(scratch64.data()), size * sizeof(double));
+    }
+    else
+        file.write(reinterpret_cast<const char *>(data), size * sizeof(double));
+
+    static const char padding[8] = {};
+    size_t bytes = size * trajectoryformat::sampleSize(type);
+    file.write(padding, trajectoryformat::columnBytes(type, size) - bytes);
+    return error;
+}
+
+/**
+ * @brief BinaryTrajectoryWriter::writeSegment appends a sampled command
+ * @param trajectory : the sampled command
+ * @param startTime : start time of the command, makes the times global
+ * @param command : the command level
+ */
+void BinaryTrajectoryWriter::writeSegment(const TrajectoryBuffer &trajectory, double startTime, int command)
+{
+    trajectoryformat::TrajectorySegmentEntry entry{};
+    entry.offset = file.bytesWritten();
+    entry.samples = trajectory.size();
+    entry.startTime = startTime;
+    entry.command = command;
+
+    //quantized times are relative to the segment, see trajectoryformat.h
+    const bool relative = static_cast<trajectoryformat::SampleType>(header.sampleType) != trajectoryformat::SampleType::Float64;
+    writeColumn(trajectory.t(), trajectory.size(), relative ? 0 : startTime);
+    double error = writeColumn(trajectory.x(), trajectory.size());
+    error = std::max(error, writeColumn(trajectory.y(), trajectory.size()));
+    error = std::max(error, writeColumn(trajectory.z(), trajectory.size()));
+    for (size_t k = 0; k < header.cableCount; k++)
+        error = std::max(error, writeColumn(trajectory.cable(k), trajectory.size()));
+
+    entry.quantizationError = static_cast<float>(error);
+    if (entry.quantizationError < error)
+        entry.quantizationError = std::nextafter(entry.quantizationError, HUGE_VALF);
+    segments.insert(segments.begin() + insertAt++, entry);
+    if (!keepTable && segments.size() >= tableChunk)
+        spillTable();
+}
+
+/**
+ * @brief BinaryTrajectoryWriter::openSpill creates the unbuffered temporary
+ *        file of the spilled table entries, removed when it is closed
+ */
+void BinaryTrajectoryWriter::openSpill()
+{
+    spill.reset(std::tmpfile());
+    if (!spill)
+        throw std::runtime_error("cannot create the temporary segment table of " + file.fileName());
+    std::setvbuf(spill.get(), nullptr, _IONBF, 0);
+}
+
+/**
+ * @brief BinaryTrajectoryWriter::spillTable moves the entries in memory to
+ *        the end of the spill file
+ */
+void BinaryTrajectoryWriter::spillTable()
+{
+    if (!spill)
+        openSpill();
+    if (std::fwrite(segments.data(), sizeof(segments[0]), segments.size(), spill.get()) != segments.size())
+        throw std::runtime_error("cannot write the temporary segment table of " + file.fileName());
+    spilled += segments.size();
+    segments.clear();
+    insertAt = 0;
+}
+
+/**
+ * @brief BinaryTrajectoryWriter::readSpill reads the next count spilled
+ *        entries
+ */
+void BinaryTrajectoryWriter::readSpill(trajectoryformat::TrajectorySegmentEntry *entries, size_t count)
+{
+    if (std::fread(entries, sizeof(*entries), count, spill.get()) != count)
+        throw std::runtime_error("cannot read the temporary segment table of " + file.fileName());
+}
+
+/**
+ * @brief BinaryTrajectoryWriter::reserve sizes the conversion buffers and the
+ *        segment table, so that writing does not allocate
+ */
+void BinaryTrajectoryWriter::reserve(size_t samples, size_t commands)
+{
+    switch (static_cast<trajectoryformat::SampleType>(header.sampleType))
+    {
+    case trajectoryformat::SampleType::Float32:
+        scratch32.reserve(samples);
+        break;
+    case trajectoryformat::SampleType::Fixed32:
+        scratchFixed.reserve(samples);
+        break;
+    default:
+        scratch64.reserve(samples);
+    }
+    //a longer run spills its table, the spill file is opened here so that
+    //writing the commands does not allocate
+    segments.reserve(std::min(commands, tableChunk));
+    if (commands > tableChunk && !keepTable && !spill)
+        openSpill();
+}
+
+/**
+ * @brief BinaryTrajectoryWriter::replaceSegments the segments are located by
+ *        the table, so the new ones are appended to the file and take the
+ *        place of [first, first + count) in the table. The samples of the
+ *        replaced segments stay in the file unreferenced.
+ * @return true, only the new segments have to be written
+ */
+bool BinaryTrajectoryWriter::replaceSegments(size_t first, size_t count)
+{
+    keepTable = true;
+    if (spilled > 0)
+    {
+        vector<trajectoryformat::TrajectorySegmentEntry> table(spilled);
+        std::rewind(spill.get());
+        readSpill(table.data(), spilled);
+        table.insert(table.end(), segments.begin(), segments.end());
+        segments.swap(table);
+        spill.reset();
+        spilled = 0;
+    }
+    first = std::min(first, segments.size());
+    segments.erase(segments.begin() + first, segments.begin() + std::min(first + count, segments.size()));
+    insertAt = first;
+    return true;
+}
+
+/**
+ * @brief BinaryTrajectoryWriter::flush hands the segments over to the file.
+ *        The file can only be read once it is closed.
+ */
+void BinaryTrajectoryWriter::flush()
+{
+    file.flush();
+}
+
+/**
+ * @brief BinaryTrajectoryWriter::close writes the segment table and the
+ *        final header
+ */
+void BinaryTrajectoryWriter::close()
+{
+    if (header.segmentTableOffset != 0)
+        return;
+    header.segmentCount = spilled + segments.size();
+    header.segmentTableOffset = file.bytesWritten();
+    if (spilled > 0)
+    {
+        //copied in chunks of tableChunk entries
+        vector<trajectoryformat::TrajectorySegmentEntry> chunk(tableChunk);
+        std::rewind(spill.get());
+        for (size_t done = 0; done < spilled; done += chunk.size())
+        {
+            size_t count = std::min(chunk.size(), spilled - done);
+            readSpill(chunk.data(), count);
+            file.write(reinterpret_cast<const char *>(chunk.data()), count * sizeof(chunk[0]));
+        }
+        spill.reset();
+    }
+    file.write(reinterpret_cast<const char *>(segments.data()),
+               segments.size() * sizeof(trajectoryformat::TrajectorySegmentEntry));
+    file.patch(0, &header, sizeof(header));
+    file.close();
+}
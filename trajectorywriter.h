@@ -0,0 +1,152 @@
+#ifndef TRAJECTORYWRITER_H
+#define TRAJECTORYWRITER_H
+
+#include "trajectorybuffer.h"
+#include "trajectoryformat.h"
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using std::array;
+using std::string;
+using std::vector;
+
+/**
+ * @brief The BufferedFile class
+ *
+ * Output file that stays open for the whole run and is written in large
+ * blocks. Numbers are formatted with std::to_chars directly into the block.
+ */
+class BufferedFile
+{
+public:
+    static const size_t blockSize = 1 << 20;
+
+    explicit BufferedFile(const string &fileName);
+    ~BufferedFile();
+
+    void write(const char *data, size_t size);
+    void put(char c);
+    void number(double value);
+    void patch(size_t offset, const void *data, size_t size);
+    void truncate(size_t offset);
+    void flush();
+    void close();
+    size_t bytesWritten() const { return written + used; }
+    const string &fileName() const { return name; }
+
+private:
+    void reserve(size_t size);
+
+    string name;
+    std::ofstream file;
+    vector<char> block;
+    size_t used{0};
+    size_t written{0};
+};
+
+/**
+ * @brief The TrajectoryWriter class
+ *
+ * Receives every sampled command of a run, in order. replaceSegments()
+ * lets an edited run patch the segments it recomputed, on a writer whose
+ * patching was enabled before the first segment.
+ */
+class TrajectoryWriter
+{
+public:
+    virtual ~TrajectoryWriter() {}
+    virtual void writeSegment(const TrajectoryBuffer &trajectory, double startTime, int command) = 0;
+    virtual void reserve(size_t, size_t) {}     //largest command in samples, commands
+    virtual void enablePatching() {}
+    virtual bool replaceSegments(size_t first, size_t count) = 0;
+    virtual void flush() = 0;
+    virtual void close() = 0;
+};
+
+enum class OutputFormat
+{
+    Text,
+    Binary
+};
+
+bool sampleTypeFromName(const string &name, trajectoryformat::SampleType &type, double &scale);
+
+/**
+ * @brief The TextTrajectoryWriter class
+ *
+ * _1.out : per command, one line per steel cable
+ * _2.out : the arena once, then per command the global times and the
+ *          x, y and z coordinates of the camera, one line each
+ */
+class TextTrajectoryWriter : public TrajectoryWriter
+{
+public:
+    TextTrajectoryWriter(const string &fileName, const array<double,3> &dim);
+    void writeSegment(const TrajectoryBuffer &trajectory, double startTime, int command) override;
+    void reserve(size_t samples, size_t commands) override;
+    void enablePatching() override;
+    bool replaceSegments(size_t first, size_t count) override;
+    void flush() override;
+    void close() override;
+
+private:
+    void writeRow(BufferedFile &out, const double *data, size_t size, double offset = 0);
+
+    BufferedFile cables;
+    BufferedFile positions;
+    bool patchable{false};
+    vector<array<size_t,2>> starts;     //offsets of every segment in both files, if patchable
+};
+
+/**
+ * @brief The BinaryTrajectoryWriter class
+ *
+ * Writes the run into a single .traj file, see trajectoryformat.h. The
+ * float32 and fixed32 samples are converted by the kernels of
+ * quantization.h, which also give the error stored per segment.
+ *
+ * The segment table is only written when the file is closed. At most
+ * tableChunk entries are kept in memory, full chunks are spilled to a
+ * temporary file and copied behind the samples by close(), so a long
+ * stream does not grow the writer. replaceSegments() takes the whole
+ * table back into memory.
+ */
+class BinaryTrajectoryWriter : public TrajectoryWriter
+{
+public:
+    static const size_t tableChunk = 4096;
+
+    BinaryTrajectoryWriter(const string &fileName, const array<double,3> &dim,
+                           int freq, int vmax, int amax,
+                           trajectoryformat::SampleType sampleType,
+                           size_t cableCount = 4,
+                           double scale = trajectoryformat::defaultFixedScale);
+    void writeSegment(const TrajectoryBuffer &trajectory, double startTime, int command) override;
+    void reserve(size_t samples, size_t commands) override;
+    bool replaceSegments(size_t first, size_t count) override;
+    void flush() override;
+    void close() override;
+
+private:
+    double writeColumn(const double *data, size_t size, double offset = 0);
+    void openSpill();
+    void spillTable();
+    void readSpill(trajectoryformat::TrajectorySegmentEntry *entries, size_t count);
+
+    BufferedFile file;
+    trajectoryformat::TrajectoryFileHeader header;
+    vector<trajectoryformat::TrajectorySegmentEntry> segments;     //the entries after the spilled ones
+    size_t insertAt{0};         //position of the next segment in segments
+    std::unique_ptr<std::FILE, int (*)(std::FILE *)> spill{nullptr, std::fclose};
+    size_t spilled{0};          //entries in the spill file
+    bool keepTable{false};      //the table is edited, it stays in memory
+    vector<double> scratch64;
+    vector<float> scratch32;
+    vector<int32_t> scratchFixed;
+};
+
+#endif // TRAJECTORYWRITER_H
@@ -0,0 +1,278 @@
+#include "validation.h"
+#include "profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace {
+
+array<double,3> point(const IOData &iodata, int i)
+{
+    return {iodata.getInstruction(i,1), iodata.getInstruction(i,2), iodata.getInstruction(i,3)};
+}
+
+double distance(const array<double,3> &a, const array<double,3> &b)
+{
+    double dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+/**
+ * @brief closestDistance distance of p to the segment from-to
+ */
+double closestDistance(const array<double,3> &p, const array<double,3> &from, const array<double,3> &to)
+{
+    array<double,3> d = {to[0] - from[0], to[1] - from[1], to[2] - from[2]};
+    double length2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+    double s = 0;
+    if (length2 > 0)
+        s = ((p[0] - from[0]) * d[0] + (p[1] - from[1]) * d[1] + (p[2] - from[2]) * d[2]) / length2;
+    s = std::min(std::max(s, 0.0), 1.0);
+    return distance(p, {from[0] + s * d[0], from[1] + s * d[1], from[2] + s * d[2]});
+}
+
+/**
+ * @brief The Segment struct, a segment prepared for many slab tests. The
+ *        boxes are closed: a segment touching a box hits it.
+ */
+struct Segment
+{
+    array<double,3> from;
+    array<double,3> inverse;    //1 / (to - from), infinite for a zero component
+
+    Segment(const array<double,3> &from_, const array<double,3> &to) : from(from_)
+    {
+        for (size_t k = 0; k < inverse.size(); k++)
+            inverse[k] = 1 / (to[k] - from[k]);
+    }
+
+    bool hits(const Box &box) const
+    {
+        double enter = 0, leave = 1;
+        for (size_t k = 0; k < inverse.size(); k++)
+        {
+            double t0 = (box.low[k] - from[k]) * inverse[k];
+            double t1 = (box.high[k] - from[k]) * inverse[k];
+            if (std::isnan(t0) || std::isnan(t1))
+                continue;           //parallel to the slab, on its boundary plane
+            enter = std::max(enter, std::min(t0, t1));
+            leave = std::min(leave, std::max(t0, t1));
+        }
+        return enter <= leave;
+    }
+};
+
+}
+
+/**
+ * @brief Box::grow the smallest box containing both boxes
+ */
+void Box::grow(const Box &other)
+{
+    for (size_t k = 0; k < low.size(); k++)
+    {
+        low[k] = std::min(low[k], other.low[k]);
+        high[k] = std::max(high[k], other.high[k]);
+    }
+}
+
+/**
+ * @brief BoxTree::BoxTree builds the hierarchy
+ * @param boxes_ : the obstacles
+ */
+BoxTree::BoxTree(const vector<Box> &boxes_) :
+    boxes(boxes_),
+    order(boxes_.size())
+{
+    for (size_t k = 0; k < order.size(); k++)
+        order[k] = static_cast<int>(k);
+    if (!boxes.empty())
+    {
+        nodes.reserve(2 * boxes.size());
+        build(0, static_cast<int>(boxes.size()));
+    }
+}
+
+/**
+ * @brief BoxTree::build the node of the boxes order[first, first+count)
+ * @return index of the node
+ */
+int BoxTree::build(int first, int count)
+{
+    const int index = static_cast<int>(nodes.size());
+    nodes.push_back(Node());
+    Box bounds = boxes[order[first]];
+    for (int k = first + 1; k < first + count; k++)
+        bounds.grow(boxes[order[k]]);
+    nodes[index].bounds = bounds;
+
+    const int leafSize = 4;
+    if (count <= leafSize)
+    {
+        nodes[index].first = first;
+        nodes[index].count = count;
+        return index;
+    }
+
+    int axis = 0;
+    for (int k = 1; k < 3; k++)
+        if (bounds.high[k] - bounds.low[k] > bounds.high[axis] - bounds.low[axis])
+            axis = k;
+    const int half = count / 2;
+    std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count,
+                     [this, axis](int a, int b) {
+                         return boxes[a].low[axis] + boxes[a].high[axis] < boxes[b].low[axis] + boxes[b].high[axis];
+                     });
+    int left = build(first, half);
+    int right = build(first + half, count - half);
+    nodes[index].left = left;
+    nodes[index].right = right;
+    return index;
+}
+
+/**
+ * @brief BoxTree::firstHit an obstacle crossed by the segment from-to
+ * @return index of the obstacle, -1 if the segment is clear
+ */
+int BoxTree::firstHit(const array<double, 3> &from, const array<double, 3> &to) const
+{
+    if (nodes.empty())
+        return -1;
+    const Segment segment(from, to);
+    int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const Node &node = nodes[stack[--top]];
+        if (!segment.hits(node.bounds))
+            continue;
+        if (node.left < 0)
+        {
+            for (int k = node.first; k < node.first + node.count; k++)
+                if (segment.hits(boxes[order[k]]))
+                    return order[k];
+        }
+        else
+        {
+            stack[top++] = node.right;
+            stack[top++] = node.left;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Validator::Validator
+ * @param iodata_ : the instructions, the start command at level 0
+ */
+Validator::Validator(const IOData &iodata_) :
+    iodata(iodata_),
+    anchors(iodata_.getAnchors()),
+    obstacles([&iodata_] {
+        vector<Box> boxes;
+        for (const array<double,6> &o : iodata_.getObstacles())
+            boxes.push_back({{std::min(o[0], o[3]), std::min(o[1], o[4]), std::min(o[2], o[5])},
+                             {std::max(o[0], o[3]), std::max(o[1], o[4]), std::max(o[2], o[5])}});
+        return boxes;
+    }())
+{
+}
+
+/**
+ * @brief Validator::validate checks every command
+ * @return the violations, in command order
+ */
+vector<Violation> Validator::validate() const
+{
+    SPIDERCAM_PROFILE_SCOPE(Validate);
+    vector<Violation> violations;
+    const int count = iodata.getInstructionsSize();
+    if (count > 0)
+        checkPoint(0, point(iodata, 0), violations);
+    for (int i = 0; i + 1 < count; i++)
+    {
+        const array<double,3> from = point(iodata, i);
+        const array<double,3> to = point(iodata, i + 1);
+        checkPoint(i, to, violations);
+        checkCables(i, from, to, violations);
+        int hit = obstacles.firstHit(from, to);
+        if (hit >= 0)
+            violations.push_back({i, Violation::Obstacle, hit, 0, 0});
+    }
+    return violations;
+}
+
+/**
+ * @brief Validator::checkPoint the waypoint has to lie in the arena
+ */
+void Validator::checkPoint(int command, const array<double, 3> &p, vector<Violation> &violations) const
+{
+    const array<double,3> dim = iodata.getDim();
+    for (size_t k = 0; k < p.size(); k++)
+    {
+        if (p[k] < 0 || p[k] > dim[k])
+        {
+            violations.push_back({command, Violation::OutsideArena, static_cast<int>(k), p[k],
+                                  p[k] < 0 ? 0 : dim[k]});
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Validator::checkCables the length of a cable along the line is
+ *        convex, its minimum is the distance of the anchor to the line and
+ *        its maximum the larger distance to an end point
+ */
+void Validator::checkCables(int command, const array<double, 3> &from, const array<double, 3> &to,
+                            vector<Violation> &violations) const
+{
+    const array<double,2> limits = iodata.getCableLimits();
+    if (limits[1] <= 0)
+        return;
+    for (size_t k = 0; k < anchors.size(); k++)
+    {
+        double shortest = closestDistance(anchors[k], from, to);
+        double longest = std::max(distance(anchors[k], from), distance(anchors[k], to));
+        if (shortest < limits[0])
+            violations.push_back({command, Violation::CableTooShort, static_cast<int>(k), shortest, limits[0]});
+        if (longest > limits[1])
+            violations.push_back({command, Violation::CableTooLong, static_cast<int>(k), longest, limits[1]});
+    }
+}
+
+/**
+ * @brief Violation::message describes the violation
+ */
+string Violation::message() const
+{
+    static const char axes[] = "xyz";
+    std::ostringstream out;
+    switch (kind)
+    {
+    case OutsideArena:
+        out << "waypoint outside of the arena, " << axes[index] << " = " << value << " (bound " << limit << ")";
+        break;
+    case CableTooShort:
+        out << "cable " << index << " shortens to " << value << " (min " << limit << ")";
+        break;
+    case CableTooLong:
+        out << "cable " << index << " extends to " << value << " (max " << limit << ")";
+        break;
+    case Obstacle:
+        out << "the line crosses obstacle " << index;
+        break;
+    }
+    return out.str();
+}
+
+/**
+ * @brief Validator::report prints the violations and a summary line
+ */
+void Validator::report(std::ostream &out, const vector<Violation> &violations)
+{
+    for (const Violation &v : violations)
+        out << "command " << v.command << ": " << v.message() << '\n';
+    out << "validation: " << violations.size() << " violation" << (violations.size() == 1 ? "" : "s") << std::endl;
+}
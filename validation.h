@@ -0,0 +1,99 @@
+#ifndef VALIDATION_H
+#define VALIDATION_H
+
+#include "inputData.h"
+#include <array>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using std::array;
+using std::string;
+using std::vector;
+
+/**
+ * @brief The Box struct, an axis-aligned box
+ */
+struct Box
+{
+    array<double,3> low{};
+    array<double,3> high{};
+
+    void grow(const Box &other);
+};
+
+/**
+ * @brief The BoxTree class
+ *
+ * Bounding volume hierarchy over the obstacles of the arena, built top-down
+ * by splitting at the median of the longest axis. A segment query only
+ * descends into the nodes its slab test hits.
+ */
+class BoxTree
+{
+public:
+    explicit BoxTree(const vector<Box> &boxes);
+
+    int firstHit(const array<double,3> &from, const array<double,3> &to) const;
+    bool empty() const { return nodes.empty(); }
+
+private:
+    struct Node
+    {
+        Box bounds;
+        int left{-1}, right{-1};    //children, -1 for a leaf
+        int first{0}, count{0};     //boxes of a leaf in `order`
+    };
+
+    int build(int first, int count);
+
+    vector<Box> boxes;
+    vector<int> order;
+    vector<Node> nodes;
+};
+
+/**
+ * @brief The Violation struct, one failed check of a command
+ */
+struct Violation
+{
+    enum Kind { OutsideArena, CableTooShort, CableTooLong, Obstacle };
+
+    int command;
+    Kind kind;
+    int index;          //cable or obstacle, -1 for a waypoint
+    double value;       //cable length, or the violating coordinate
+    double limit;       //drum limit, or the arena bound
+
+    string message() const;
+};
+
+/**
+ * @brief The Validator class
+ *
+ * Pre-flight check of the instruction list, without sampling. Every command
+ * is a straight line, so all checks are analytic: the waypoints must lie in
+ * the arena, the length of every cable along the line (between the distance
+ * of its anchor to the line and the larger end point distance) must stay
+ * within the drum limits of the `cable min max` directive, and the line
+ * must not cross an `obstacle x0 y0 z0 x1 y1 z1` box.
+ */
+class Validator
+{
+public:
+    explicit Validator(const IOData &iodata);
+
+    vector<Violation> validate() const;
+    static void report(std::ostream &out, const vector<Violation> &violations);
+
+private:
+    void checkPoint(int command, const array<double,3> &point, vector<Violation> &violations) const;
+    void checkCables(int command, const array<double,3> &from, const array<double,3> &to,
+                     vector<Violation> &violations) const;
+
+    const IOData &iodata;
+    AnchorPoints anchors;
+    BoxTree obstacles;
+};
+
+#endif // VALIDATION_H
@@ -0,0 +1,108 @@
+#include "workstealingpool.h"
+
+/**
+ * @brief WorkStealingPool::WorkStealingPool starts the workers
+ * @param threads : number of workers, at least 1
+ */
+WorkStealingPool::WorkStealingPool(unsigned threads)
+{
+    if (threads == 0)
+        threads = 1;
+    for (unsigned k = 0; k < threads; k++)
+        queues.emplace_back(new Queue);
+    for (unsigned k = 0; k < threads; k++)
+        workers.emplace_back(&WorkStealingPool::run, this, k);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+/**
+ * @brief WorkStealingPool::submit distributes the tasks round-robin
+ * @param task : the task to be executed
+ */
+void WorkStealingPool::submit(std::function<void()> task)
+{
+    unsigned target;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        target = next++ % queues.size();
+        pending++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        queued++;
+    }
+    wake.notify_one();
+}
+
+/**
+ * @brief WorkStealingPool::wait blocks until every submitted task is finished
+ */
+void WorkStealingPool::wait()
+{
+    std::unique_lock<std::mutex> lock(stateMutex);
+    idle.wait(lock, [this] { return pending == 0; });
+}
+
+/**
+ * @brief WorkStealingPool::take the next task of a worker, its own or a stolen one
+ * @return false when all queues are empty
+ */
+bool WorkStealingPool::take(unsigned worker, std::function<void()> &task)
+{
+    for (size_t k = 0; k < queues.size(); k++)
+    {
+        Queue &queue = *queues[(worker + k) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+            continue;
+        if (k == 0)
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        else
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::run(unsigned worker)
+{
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(stateMutex);
+            wake.wait(lock, [this] { return stopping || queued > 0; });
+            if (queued == 0)
+                return;
+            queued--;
+        }
+
+        std::function<void()> task;
+        while (!take(worker, task))
+            std::this_thread::yield();
+        task();
+
+        std::lock_guard<std::mutex> lock(stateMutex);
+        if (--pending == 0)
+            idle.notify_all();
+    }
+}
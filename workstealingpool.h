@@ -0,0 +1,54 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using std::vector;
+
+/**
+ * @brief The WorkStealingPool class
+ *
+ * Fixed set of worker threads, each with its own task queue. A worker takes
+ * tasks from the front of its own queue and, once it is empty, steals from
+ * the back of the queues of the other workers.
+ */
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(unsigned threads);
+    ~WorkStealingPool();
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    void submit(std::function<void()> task);
+    void wait();
+    unsigned size() const { return static_cast<unsigned>(workers.size()); }
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool take(unsigned worker, std::function<void()> &task);
+    void run(unsigned worker);
+
+    vector<std::unique_ptr<Queue>> queues;
+    vector<std::thread> workers;
+    std::mutex stateMutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    size_t queued{0};       //submitted, not started
+    size_t pending{0};      //submitted, not finished
+    unsigned next{0};
+    bool stopping{false};
+};
+
+#endif // WORKSTEALINGPOOL_H